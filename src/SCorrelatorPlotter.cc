@@ -9,6 +9,28 @@
 
 #define SCORRELATORPLOTTER_CC
 
+// standard c includes
+#include <set>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include <algorithm>
+// root includes
+#include <TKey.h>
+#include <TMath.h>
+#include <TROOT.h>
+#include <TClass.h>
+#include <TRandom3.h>
+#include <TSystem.h>
+#include <TFileMerger.h>
+#include <ROOT/TSeq.hxx>
+#include <Math/MinimizerOptions.h>
+#include <ROOT/RDataFrame.hxx>
+#include <ROOT/TThreadExecutor.hxx>
 // user includes
 #include "SCorrelatorPlotter.h"
 
@@ -18,10 +40,2175 @@ using namespace std;
 
 namespace SColdQcdCorrelatorAnalysis {
 
+  // ctor/dtor ----------------------------------------------------------------
+
+  SCorrelatorPlotter::SCorrelatorPlotter() {
+
+    /* nothing to do */
+
+  }  // end ctor
+
+
+
+  SCorrelatorPlotter::~SCorrelatorPlotter() {
+
+    /* nothing to do */
+
+  }  // end dtor
+
+
+
   // plotting methods  -------------------------------------------------------
 
   /* TODO these go here */
 
+
+
+  // systematic variation sweeps ----------------------------------------------
+
+  bool SCorrelatorPlotter::DoVariationSweep(const SSweepConfig& config) {
+
+    cout << "\n  Beginning variation sweep '" << config.outName << "'..." << endl;
+
+    // load all variations into a single block
+    SVariationBlock block = LoadVariations(config);
+    if (block.nVar == 0) {
+      cerr << "PANIC: couldn't load variations for sweep '" << config.outName << "'!\n" << endl;
+      return false;
+    }
+    cout << "    Loaded " << block.nVar << " variations." << endl;
+
+    // scale, normalize and take ratios in one pass
+    ProcessVariations(block, config);
+    cout << "    Processed variations." << endl;
+
+    // open output
+    TFile* fOutput = new TFile(config.outFile.data(), "update");
+    if (!fOutput || fOutput -> IsZombie()) {
+      cerr << "PANIC: couldn't open output file '" << config.outFile << "'!\n" << endl;
+      return false;
+    }
+
+    // save variations and band
+    fOutput -> cd();
+    for (size_t iVar = 0; iVar < block.nVar; iVar++) {
+      TH1D* hVar = MakeVariationHist(block, iVar, config.outName + "_" + block.labels[iVar]);
+      hVar -> Write();
+      delete hVar;
+    }
+
+    TGraphAsymmErrors* gBand = MakeVariationBand(block, config.nominal, config.band, config.outName + "_band");
+    gBand   -> Write();
+    fOutput -> Close();
+    delete gBand;
+
+    cout << "  Finished variation sweep!\n" << endl;
+    return true;
+
+  }  // end 'DoVariationSweep(SSweepConfig&)'
+
+
+
+  SVariationBlock SCorrelatorPlotter::LoadVariations(const SSweepConfig& config) {
+
+    SVariationBlock block;
+    if (config.inFiles.empty() || (config.inFiles.size() != config.inHists.size())) {
+      cerr << "WARNING: need exactly one histogram per input file in a sweep!" << endl;
+      return block;
+    }
+    if (config.nominal >= config.inFiles.size()) {
+      cerr << "WARNING: nominal variation " << config.nominal << " is out of range!" << endl;
+      return block;
+    }
+
+    const size_t nVar = config.inFiles.size();
+    block.nVar = nVar;
+    for (size_t iVar = 0; iVar < nVar; iVar++) {
+
+      TFile* fInput = TFile::Open(config.inFiles[iVar].data(), "read");
+      if (!fInput || fInput -> IsZombie()) {
+        cerr << "WARNING: couldn't open variation file '" << config.inFiles[iVar] << "'!" << endl;
+        return SVariationBlock();
+      }
+
+      TH1* hInput = (TH1*) fInput -> Get(config.inHists[iVar].data());
+      if (!hInput) {
+        cerr << "WARNING: couldn't grab variation histogram '" << config.inHists[iVar] << "'!" << endl;
+        fInput -> Close();
+        return SVariationBlock();
+      }
+
+      // first variation sets the binning
+      if (!AppendToBlock(block, hInput, iVar)) {
+        cerr << "WARNING: variation '" << config.inFiles[iVar] << "' has inconsistent binning!" << endl;
+        fInput -> Close();
+        return SVariationBlock();
+      }
+      block.labels.push_back( (iVar < config.labels.size()) ? config.labels[iVar] : "var" + to_string(iVar) );
+      fInput -> Close();
+    }
+    return block;
+
+  }  // end 'LoadVariations(SSweepConfig&)'
+
+
+
+  void SCorrelatorPlotter::ProcessVariations(SVariationBlock& block, const SSweepConfig& config) {
+
+    // same scale for every variation
+    const vector<double>   scales(block.nVar, config.doScale ? config.projScale : 1.);
+    const optional<size_t> ratioTo = config.doRatio ? optional<size_t>(config.nominal) : nullopt;
+    ProcessBlock(block, scales, config.doNorm, config.normRange, ratioTo);
+    return;
+
+  }  // end 'ProcessVariations(SVariationBlock&, SSweepConfig&)'
+
+
+
+  TH1D* SCorrelatorPlotter::MakeVariationHist(const SVariationBlock& block, const size_t iVar, const string& name) {
+
+    TH1D* hVar = new TH1D(name.data(), "", block.nBin, block.edges.data());
+    for (size_t iBin = 0; iBin < block.nBin; iBin++) {
+      hVar -> SetBinContent(iBin + 1, block.Value(iBin, iVar));
+      hVar -> SetBinError(iBin + 1, block.Error(iBin, iVar));
+    }
+    return hVar;
+
+  }  // end 'MakeVariationHist(SVariationBlock&, size_t, string&)'
+
+
+
+  TGraphAsymmErrors* SCorrelatorPlotter::MakeVariationBand(const SVariationBlock& block, const size_t nominal, const Band band, const string& name) {
+
+    TGraphAsymmErrors* gBand = new TGraphAsymmErrors(block.nBin);
+    gBand -> SetName(name.data());
+
+    for (size_t iBin = 0; iBin < block.nBin; iBin++) {
+
+      // deviations of each variation w.r.t. nominal
+      const double nom = block.Value(iBin, nominal);
+      double       lo  = 0.;
+      double       hi  = 0.;
+      for (size_t iVar = 0; iVar < block.nVar; iVar++) {
+        if (iVar == nominal) continue;
+
+        const double diff = block.Value(iBin, iVar) - nom;
+        switch (band) {
+          case Band::Envelope:
+            lo = max(lo, -diff);
+            hi = max(hi, diff);
+            break;
+          case Band::Quadrature:
+            if (diff < 0.) {
+              lo += diff * diff;
+            } else {
+              hi += diff * diff;
+            }
+            break;
+        }
+      }
+      if (band == Band::Quadrature) {
+        lo = sqrt(lo);
+        hi = sqrt(hi);
+      }
+
+      const double center = 0.5 * (block.edges[iBin] + block.edges[iBin + 1]);
+      const double width  = 0.5 * (block.edges[iBin + 1] - block.edges[iBin]);
+      gBand -> SetPoint(iBin, center, nom);
+      gBand -> SetPointError(iBin, width, width, lo, hi);
+    }
+    return gBand;
+
+  }  // end 'MakeVariationBand(SVariationBlock&, size_t, Band, string&)'
+
+
+
+  // luminosity projection scans ---------------------------------------------
+
+  bool SCorrelatorPlotter::DoProjectionScan(const vector<TH1D*>& hists, const SScanConfig& config) {
+
+    cout << "\n  Beginning projection scan over " << config.scenarios.size() << " scenarios..." << endl;
+
+    // scale and normalize everything at once
+    vector<vector<TH1D*>> projections = ScanProjections(hists, config);
+    if (projections.empty()) {
+      cerr << "PANIC: projection scan produced nothing!\n" << endl;
+      return false;
+    }
+    cout << "    Scaled histograms." << endl;
+
+    TFile* fOutput = new TFile(config.outFile.data(), "recreate");
+    if (!fOutput || fOutput -> IsZombie()) {
+      cerr << "PANIC: couldn't open output file '" << config.outFile << "'!\n" << endl;
+      return false;
+    }
+
+    // save a plot and the histograms for each scenario
+    for (size_t iScen = 0; iScen < config.scenarios.size(); iScen++) {
+      fOutput -> cd();
+      TCanvas* plot = MakeScanCanvas(projections[iScen], config, config.scenarios[iScen]);
+      plot -> Write();
+      plot -> Close();
+      for (TH1D* projection : projections[iScen]) {
+        if (!projection) continue;
+        projection -> Write();
+      }
+    }
+    cout << "    Saved plots and histograms." << endl;
+
+    // projections are only needed for the output
+    for (vector<TH1D*>& scenario : projections) {
+      for (TH1D* projection : scenario) {
+        delete projection;
+      }
+    }
+
+    fOutput -> cd();
+    fOutput -> Close();
+    cout << "  Finished projection scan!\n" << endl;
+    return true;
+
+  }  // end 'DoProjectionScan(vector<TH1D*>&, SScanConfig&)'
+
+
+
+  vector<vector<TH1D*>> SCorrelatorPlotter::ScanProjections(const vector<TH1D*>& hists, const SScanConfig& config) {
+
+    const size_t nScen = config.scenarios.size();
+    const size_t nHist = hists.size();
+
+    vector<vector<TH1D*>> projections;
+    if (nScen == 0) {
+      cerr << "WARNING: no luminosity scenarios to scan!" << endl;
+      return projections;
+    }
+
+    vector<double> scales;
+    for (const SLumiScenario& scenario : config.scenarios) {
+      scales.push_back( scenario.ScaleFactor() );
+    }
+
+    // each histogram becomes a block with one "variation"
+    // per scenario, so all scenarios are done in one pass
+    projections.assign(nScen, vector<TH1D*>(nHist, nullptr));
+    for (size_t iHist = 0; iHist < nHist; iHist++) {
+
+      const TH1D* hist = hists[iHist];
+      if (!hist) {
+        cerr << "WARNING: histogram " << iHist << " to scan is null, skipping!" << endl;
+        continue;
+      }
+
+      SVariationBlock block;
+      block.nVar = nScen;
+      for (size_t iScen = 0; iScen < nScen; iScen++) {
+        AppendToBlock(block, hist, iScen);
+      }
+      ProcessBlock(block, scales, config.doNorm, config.normRange, nullopt);
+
+      // clone inputs so the projections keep their styles
+      for (size_t iScen = 0; iScen < nScen; iScen++) {
+        const string name       = string(hist -> GetName()) + "_" + config.scenarios[iScen].label;
+        TH1D*        projection = (TH1D*) hist -> Clone(name.data());
+        for (size_t iBin = 0; iBin < block.nBin; iBin++) {
+          projection -> SetBinContent(iBin + 1, block.Value(iBin, iScen));
+          projection -> SetBinError(iBin + 1, block.Error(iBin, iScen));
+        }
+        projections[iScen][iHist] = projection;
+      }
+    }
+    return projections;
+
+  }  // end 'ScanProjections(vector<TH1D*>&, SScanConfig&)'
+
+
+
+  // histograms from correlator trees ----------------------------------------
+
+  vector<TH1D*> SCorrelatorPlotter::MakeHistsFromTrees(const STreeConfig& config) {
+
+    cout << "\n  Beginning to fill " << config.hists.size() << " histograms from tree '" << config.tree << "'..." << endl;
+
+    // implicit mt has to be on before the frame is made; it's
+    // process-wide, so switch it back off if it's turned on here
+    const bool doMT = (m_nThreads > 1) && !ROOT::IsImplicitMTEnabled();
+    if (doMT) {
+      ROOT::EnableImplicitMT(m_nThreads);
+    }
+
+    // rdataframe throws on e.g. a missing tree, an unknown
+    // column or a cut that doesn't compile
+    vector<TH1D*> hists(config.hists.size(), nullptr);
+    try {
+      ROOT::RDataFrame frame(config.tree, config.inFiles);
+
+      // book everything lazily, sharing filters between
+      // histograms with the same cut (e.g. a jet pt bin);
+      // skipped histograms keep an empty slot so outputs
+      // line up with config.hists
+      map<string, ROOT::RDF::RNode>                 filters;
+      vector<optional<ROOT::RDF::RResultPtr<TH1D>>> results(config.hists.size());
+      size_t                                        nBooked = 0;
+      for (size_t iHist = 0; iHist < config.hists.size(); iHist++) {
+
+        const STreeHistConfig& hist = config.hists[iHist];
+        if (hist.edges.size() < 2) {
+          cerr << "WARNING: histogram '" << hist.name << "' needs at least 2 bin edges, skipping!" << endl;
+          continue;
+        }
+
+        auto filter = filters.find(hist.cut);
+        if (filter == filters.end()) {
+          ROOT::RDF::RNode node = hist.cut.empty() ? ROOT::RDF::RNode(frame) : ROOT::RDF::RNode(frame.Filter(hist.cut, hist.cut));
+          filter = filters.emplace(hist.cut, node).first;
+        }
+
+        const ROOT::RDF::TH1DModel model(hist.name.data(), "", hist.edges.size() - 1, hist.edges.data());
+        if (hist.weight.empty()) {
+          results[iHist] = filter -> second.Histo1D(model, hist.var);
+        } else {
+          results[iHist] = filter -> second.Histo1D(model, hist.var, hist.weight);
+        }
+        ++nBooked;
+      }
+      cout << "    Booked " << nBooked << " histograms." << endl;
+
+      // first access triggers a single event loop for all of them
+      for (size_t iHist = 0; iHist < results.size(); iHist++) {
+        if (!results[iHist].has_value()) continue;
+
+        TH1D* hist = (TH1D*) results[iHist].value() -> Clone();
+        hist -> SetDirectory(nullptr);
+        hists[iHist] = hist;
+      }
+    } catch (const exception& error) {
+      cerr << "PANIC: couldn't fill histograms from tree '" << config.tree << "': " << error.what() << "\n" << endl;
+      for (TH1D*& hist : hists) {
+        delete hist;
+        hist = nullptr;
+      }
+      if (doMT) ROOT::DisableImplicitMT();
+      return hists;
+    }
+
+    if (doMT) ROOT::DisableImplicitMT();
+    cout << "  Finished filling histograms from trees!\n" << endl;
+    return hists;
+
+  }  // end 'MakeHistsFromTrees(STreeConfig&)'
+
+
+
+  // ratio matrices -----------------------------------------------------------
+
+  bool SCorrelatorPlotter::DoRatioMatrix(const SRatioConfig& config) {
+
+    cout << "\n  Beginning ratio matrix..." << endl;
+
+    // load numerators and denominators
+    SVariationBlock nums = LoadRatioInputs(config.numerators);
+    SVariationBlock dens = LoadRatioInputs(config.denominators);
+    if ((nums.nVar == 0) || (dens.nVar == 0)) {
+      cerr << "PANIC: couldn't load inputs for ratio matrix!\n" << endl;
+      return false;
+    }
+    if (nums.edges != dens.edges) {
+      cerr << "PANIC: numerators and denominators have different binning!\n" << endl;
+      return false;
+    }
+    cout << "    Loaded " << nums.nVar << " numerators and " << dens.nVar << " denominators." << endl;
+
+    // group numerators by the denominator they share
+    vector<vector<size_t>> numsPerDen(dens.nVar);
+    if (config.pairs.empty()) {
+      for (size_t iDen = 0; iDen < dens.nVar; iDen++) {
+        for (size_t iNum = 0; iNum < nums.nVar; iNum++) {
+          numsPerDen[iDen].push_back(iNum);
+        }
+      }
+    } else {
+      for (const auto& [iNum, iDen] : config.pairs) {
+        if ((iNum >= nums.nVar) || (iDen >= dens.nVar)) {
+          cerr << "WARNING: ratio (" << iNum << ", " << iDen << ") is out of range, skipping!" << endl;
+          continue;
+        }
+        numsPerDen[iDen].push_back(iNum);
+      }
+    }
+
+    vector<SVariationBlock> ratios = DivideByShared(nums, dens, numsPerDen);
+    cout << "    Calculated ratios." << endl;
+
+    TFile* fOutput = new TFile(config.outFile.data(), "recreate");
+    if (!fOutput || fOutput -> IsZombie()) {
+      cerr << "PANIC: couldn't open output file '" << config.outFile << "'!\n" << endl;
+      return false;
+    }
+
+    // save inputs
+    fOutput -> cd();
+    vector<TH1D*> hNums;
+    vector<TH1D*> hDens;
+    for (size_t iNum = 0; iNum < nums.nVar; iNum++) {
+      hNums.push_back( MakeVariationHist(nums, iNum, "h" + nums.labels[iNum]) );
+      hNums.back() -> Write();
+    }
+    for (size_t iDen = 0; iDen < dens.nVar; iDen++) {
+      hDens.push_back( MakeVariationHist(dens, iDen, "h" + dens.labels[iDen]) );
+      hDens.back() -> Write();
+    }
+
+    // and the matrix itself, one panel per denominator
+    for (size_t iDen = 0; iDen < dens.nVar; iDen++) {
+
+      vector<TH1D*> hRatios;
+      vector<TH1D*> hPanelNums;
+      for (size_t iRatio = 0; iRatio < numsPerDen[iDen].size(); iRatio++) {
+        const size_t iNum = numsPerDen[iDen][iRatio];
+        const string name = "hRatio_" + nums.labels[iNum] + "_over_" + dens.labels[iDen];
+        hRatios.push_back( MakeVariationHist(ratios[iDen], iRatio, name) );
+        hRatios.back() -> Write();
+        hPanelNums.push_back( hNums[iNum] );
+      }
+
+      if (config.doPanels && !hRatios.empty()) {
+        TCanvas* panel = MakeRatioPanel(hDens[iDen], hPanelNums, hRatios, config);
+        fOutput -> cd();
+        panel   -> Write();
+        panel   -> Close();
+      }
+    }
+    cout << "    Saved ratios and panels." << endl;
+
+    fOutput -> cd();
+    fOutput -> Close();
+    cout << "  Finished ratio matrix!\n" << endl;
+    return true;
+
+  }  // end 'DoRatioMatrix(SRatioConfig&)'
+
+
+
+  SVariationBlock SCorrelatorPlotter::LoadRatioInputs(const vector<SRatioInput>& inputs) {
+
+    SVariationBlock block;
+    block.nVar = inputs.size();
+    for (size_t iInput = 0; iInput < inputs.size(); iInput++) {
+
+      const SRatioInput& input = inputs[iInput];
+      if (input.parts.empty()) {
+        cerr << "WARNING: ratio input '" << input.label << "' has no parts!" << endl;
+        return SVariationBlock();
+      }
+
+      // sum parts, adding errors in quadrature
+      for (const auto& [file, name] : input.parts) {
+
+        TFile* fInput = TFile::Open(file.data(), "read");
+        if (!fInput || fInput -> IsZombie()) {
+          cerr << "WARNING: couldn't open ratio input file '" << file << "'!" << endl;
+          return SVariationBlock();
+        }
+
+        TH1* hInput = (TH1*) fInput -> Get(name.data());
+        if (!hInput) {
+          cerr << "WARNING: couldn't grab ratio input '" << name << "' from '" << file << "'!" << endl;
+          fInput -> Close();
+          return SVariationBlock();
+        }
+
+        // first part sets the binning
+        if (!AppendToBlock(block, hInput, iInput, input.weight)) {
+          cerr << "WARNING: ratio input '" << name << "' has inconsistent binning!" << endl;
+          fInput -> Close();
+          return SVariationBlock();
+        }
+        fInput -> Close();
+      }
+      block.labels.push_back(input.label);
+    }
+    return block;
+
+  }  // end 'LoadRatioInputs(vector<SRatioInput>&)'
+
+
+
+  vector<SVariationBlock> SCorrelatorPlotter::DivideByShared(
+    const SVariationBlock& nums,
+    const SVariationBlock& dens,
+    const vector<vector<size_t>>& numsPerDen
+  ) {
+
+    vector<SVariationBlock> ratios(dens.nVar);
+
+    // denominators are independent of each other
+    ROOT::TThreadExecutor pool(m_nThreads);
+    pool.Foreach(
+      [&](const size_t iDen) {
+
+        const vector<size_t>& iNums = numsPerDen[iDen];
+        const size_t          nNum  = iNums.size();
+
+        SVariationBlock& ratio = ratios[iDen];
+        ratio.nBin  = nums.nBin;
+        ratio.nVar  = nNum;
+        ratio.edges = nums.edges;
+        ratio.values.assign(ratio.nBin * nNum, 0.);
+        ratio.errors.assign(ratio.nBin * nNum, 0.);
+        for (const size_t iNum : iNums) {
+          ratio.labels.push_back( nums.labels[iNum] + "_over_" + dens.labels[iDen] );
+        }
+
+        for (size_t iBin = 0; iBin < nums.nBin; iBin++) {
+
+          // reciprocal and error term of denominator are
+          // computed once and shared by all numerators:
+          //   r = n / d, e_r^2 = e_n^2 / d^2 + n^2 e_d^2 / d^4
+          const double den = dens.Value(iBin, iDen);
+          if (den == 0.) continue;
+
+          const double inv     = 1. / den;
+          const double inv2    = inv * inv;
+          const double errTerm = dens.Error(iBin, iDen) * dens.Error(iBin, iDen) * inv2 * inv2;
+
+          double* vals = &ratio.values[iBin * nNum];
+          double* errs = &ratio.errors[iBin * nNum];
+          for (size_t iRatio = 0; iRatio < nNum; iRatio++) {
+            const double num    = nums.Value(iBin, iNums[iRatio]);
+            const double numErr = nums.Error(iBin, iNums[iRatio]);
+            vals[iRatio] = num * inv;
+            errs[iRatio] = sqrt((numErr * numErr * inv2) + (num * num * errTerm));
+          }
+        }
+      },
+      ROOT::TSeq<size_t>(dens.nVar)
+    );
+    return ratios;
+
+  }  // end 'DivideByShared(SVariationBlock&, SVariationBlock&, vector<vector<size_t>>&)'
+
+
+
+  // unfolding ----------------------------------------------------------------
+
+  vector<TH1D*> SCorrelatorPlotter::UnfoldHists(const vector<TH1*>& measured, const vector<SUnfoldConfig>& configs) {
+
+    vector<TH1D*> unfolded(measured.size(), nullptr);
+    if (measured.size() != configs.size()) {
+      cerr << "WARNING: need exactly one unfolding config per measured histogram!" << endl;
+      return unfolded;
+    }
+
+    // normalize responses up front (once per response, so
+    // shared across iterations and pt bins), and pull out
+    // priors and measured contents & errors; the cache only
+    // lives for this call, so its keys can't go stale
+    map<pair<const TH2*, const TH1*>, SResponseCache> cache;
+    vector<const SResponseCache*>                     responses(measured.size(), nullptr);
+    vector<vector<double>>                            priors(measured.size());
+    vector<vector<double>>                            meas(measured.size());
+    vector<vector<double>>                            measErr(measured.size());
+    for (size_t iHist = 0; iHist < measured.size(); iHist++) {
+
+      if (!measured[iHist] || !configs[iHist].response) {
+        cerr << "WARNING: missing measured histogram or response for unfolding " << iHist << "!" << endl;
+        continue;
+      }
+
+      const SResponseCache& response = GetResponse(configs[iHist], cache);
+      if (size_t(measured[iHist] -> GetNbinsX()) != response.nDet) {
+        cerr << "WARNING: '" << measured[iHist] -> GetName() << "' doesn't match detector binning of response!" << endl;
+        continue;
+      }
+
+      // starting prior: provided one or truth projection, normalized
+      const TH1* hPrior = configs[iHist].prior;
+      double     total  = 0.;
+      priors[iHist].assign(response.nTrue, 0.);
+      for (size_t iTrue = 0; iTrue < response.nTrue; iTrue++) {
+        priors[iHist][iTrue] = hPrior ? hPrior -> GetBinContent(iTrue + 1) : response.nTruth[iTrue];
+        total += priors[iHist][iTrue];
+      }
+      for (double& prior : priors[iHist]) {
+        prior = (total > 0.) ? (prior / total) : (1. / response.nTrue);
+      }
+
+      responses[iHist] = &response;
+      for (size_t iDet = 1; iDet <= response.nDet; iDet++) {
+        meas[iHist].push_back( measured[iHist] -> GetBinContent(iDet) );
+        measErr[iHist].push_back( measured[iHist] -> GetBinError(iDet) );
+      }
+    }
+
+    // unfold every histogram (e.g. every jet pt bin) in parallel
+    vector<vector<double>> unfold(measured.size());
+    vector<vector<double>> unfoldErr(measured.size());
+    ROOT::TThreadExecutor  pool(m_nThreads);
+    pool.Foreach(
+      [&](const size_t iHist) {
+        if (!responses[iHist]) return;
+        RunUnfolding(*responses[iHist], priors[iHist], meas[iHist], measErr[iHist], configs[iHist].nIter, unfold[iHist], unfoldErr[iHist]);
+      },
+      ROOT::TSeq<size_t>(measured.size())
+    );
+
+    // collect results into truth-level histograms
+    for (size_t iHist = 0; iHist < measured.size(); iHist++) {
+      if (!responses[iHist]) continue;
+
+      const SResponseCache& response = *responses[iHist];
+      const string          name     = string(measured[iHist] -> GetName()) + "_unfolded";
+      unfolded[iHist] = new TH1D(name.data(), "", response.nTrue, response.trueEdges.data());
+      unfolded[iHist] -> Sumw2();
+      for (size_t iTrue = 0; iTrue < response.nTrue; iTrue++) {
+        unfolded[iHist] -> SetBinContent(iTrue + 1, unfold[iHist][iTrue]);
+        unfolded[iHist] -> SetBinError(iTrue + 1, unfoldErr[iHist][iTrue]);
+      }
+    }
+    return unfolded;
+
+  }  // end 'UnfoldHists(vector<TH1*>&, vector<SUnfoldConfig>&)'
+
+
+
+  TH1D* SCorrelatorPlotter::UnfoldHist(TH1* measured, const SUnfoldConfig& config) {
+
+    return UnfoldHists({measured}, {config}).front();
+
+  }  // end 'UnfoldHist(TH1*, SUnfoldConfig&)'
+
+
+
+  // covariance propagation ---------------------------------------------------
+
+  SCovHist SCorrelatorPlotter::MakeCovHist(TH1D* hist, const TH2* cov) {
+
+    SCovHist covHist;
+    if (!hist) {
+      cerr << "WARNING: no histogram to attach a covariance to!" << endl;
+      return covHist;
+    }
+
+    covHist.hist = hist;
+    covHist.nBin = hist -> GetNbinsX();
+    covHist.cov.assign(covHist.nBin * covHist.nBin, 0.);
+
+    // use full covariance if provided, else errors are uncorrelated
+    const bool useCov = cov && (size_t(cov -> GetNbinsX()) == covHist.nBin) && (size_t(cov -> GetNbinsY()) == covHist.nBin);
+    if (cov && !useCov) {
+      cerr << "WARNING: covariance of '" << hist -> GetName() << "' has the wrong size, using diagonal errors!" << endl;
+    }
+
+    for (size_t iBin = 0; iBin < covHist.nBin; iBin++) {
+      if (useCov) {
+        for (size_t jBin = 0; jBin < covHist.nBin; jBin++) {
+          covHist.Cov(iBin, jBin) = cov -> GetBinContent(iBin + 1, jBin + 1);
+        }
+      } else {
+        const double error = hist -> GetBinError(iBin + 1);
+        covHist.Cov(iBin, iBin) = error * error;
+      }
+    }
+    SyncCovErrors(covHist);
+    return covHist;
+
+  }  // end 'MakeCovHist(TH1D*, TH2*)'
+
+
+
+  void SCorrelatorPlotter::ScaleCov(SCovHist& hist, const double valScale, const double covScale) {
+
+    // covScale is valScale^2 for a plain rescaling, or
+    // e.g. 1/s when projecting to a luminosity as in
+    // the BUP plots (contents by 1/s, errors by 1/sqrt(s))
+    for (size_t iBin = 0; iBin < hist.nBin; iBin++) {
+      hist.hist -> SetBinContent(iBin + 1, valScale * hist.hist -> GetBinContent(iBin + 1));
+    }
+    for (double& cov : hist.cov) {
+      cov *= covScale;
+    }
+    SyncCovErrors(hist);
+    return;
+
+  }  // end 'ScaleCov(SCovHist&, double, double)'
+
+
+
+  void SCorrelatorPlotter::NormalizeCov(SCovHist& hist, const pair<double, double>& range) {
+
+    const size_t nBin = hist.nBin;
+
+    // same integration range as the plotting macros
+    const vector<double> edges  = GetEdges(hist.hist -> GetXaxis());
+    const size_t         iStart = FindBlockBin(edges, range.first);
+    const size_t         iStop  = FindBlockBin(edges, range.second);
+
+    double integral = 0.;
+    for (size_t iBin = iStart; iBin <= iStop; iBin++) {
+      integral += hist.hist -> GetBinContent(iBin + 1);
+    }
+    if (integral <= 0.) return;
+
+    // y = x / I with I = sum_R x has jacobian
+    //   J = (1 - y 1_R^T) / I
+    // so J C J^T = (C - y a^T - a y^T + s y y^T) / I^2
+    // with a = C 1_R and s = 1_R^T C 1_R
+    vector<double> norm(nBin, 0.);
+    vector<double> rowSum(nBin, 0.);
+    double         total = 0.;
+    for (size_t iBin = 0; iBin < nBin; iBin++) {
+      norm[iBin] = hist.hist -> GetBinContent(iBin + 1) / integral;
+
+      const double* row = &hist.cov[iBin * nBin];
+      for (size_t jBin = iStart; jBin <= iStop; jBin++) {
+        rowSum[iBin] += row[jBin];
+      }
+      if ((iBin >= iStart) && (iBin <= iStop)) {
+        total += rowSum[iBin];
+      }
+    }
+
+    const double invI2 = 1. / (integral * integral);
+    for (size_t iBin = 0; iBin < nBin; iBin++) {
+      double* row = &hist.cov[iBin * nBin];
+      for (size_t jBin = 0; jBin < nBin; jBin++) {
+        row[jBin] = invI2 * (row[jBin] - (norm[iBin] * rowSum[jBin]) - (rowSum[iBin] * norm[jBin]) + (total * norm[iBin] * norm[jBin]));
+      }
+      hist.hist -> SetBinContent(iBin + 1, norm[iBin]);
+    }
+    SyncCovErrors(hist);
+    return;
+
+  }  // end 'NormalizeCov(SCovHist&, pair<double, double>&)'
+
+
+
+  SCovHist SCorrelatorPlotter::TransformCov(const SCovHist& hist, const vector<double>& jacobian, const vector<double>& edges, const string& name) {
+
+    // general linear map y = J x onto new binning,
+    // with J stored row-major (nOut x nIn)
+    SCovHist result;
+    if (!hist.hist || (edges.size() < 2)) {
+      cerr << "WARNING: need an input histogram and at least 2 bin edges to transform '" << name << "'!" << endl;
+      return result;
+    }
+
+    const size_t nIn  = hist.nBin;
+    const size_t nOut = edges.size() - 1;
+    if (jacobian.size() != (nOut * nIn)) {
+      cerr << "WARNING: jacobian for '" << name << "' has the wrong size!" << endl;
+      return result;
+    }
+
+    result.hist = new TH1D(name.data(), "", nOut, edges.data());
+    result.nBin = nOut;
+    for (size_t iOut = 0; iOut < nOut; iOut++) {
+      const double* row   = &jacobian[iOut * nIn];
+      double        value = 0.;
+      for (size_t iIn = 0; iIn < nIn; iIn++) {
+        value += row[iIn] * hist.hist -> GetBinContent(iIn + 1);
+      }
+      result.hist -> SetBinContent(iOut + 1, value);
+    }
+
+    SandwichCov(jacobian, nOut, nIn, hist.cov, result.cov);
+    SyncCovErrors(result);
+    return result;
+
+  }  // end 'TransformCov(SCovHist&, vector<double>&, vector<double>&, string&)'
+
+
+
+  SCovHist SCorrelatorPlotter::RebinCov(const SCovHist& hist, const vector<double>& edges, const string& name) {
+
+    if (!hist.hist || (edges.size() < 2)) {
+      cerr << "WARNING: need an input histogram and at least 2 bin edges to rebin '" << name << "'!" << endl;
+      return SCovHist();
+    }
+
+    // assign each old bin to the new bin holding its center;
+    // bins outside the new range are dropped
+    const size_t    nOld = hist.nBin;
+    const size_t    nNew = edges.size() - 1;
+    vector<int64_t> group(nOld, -1);
+    for (size_t iOld = 0; iOld < nOld; iOld++) {
+      const double center = hist.hist -> GetBinCenter(iOld + 1);
+      if ((center < edges.front()) || (center >= edges.back())) continue;
+      group[iOld] = FindBlockBin(edges, center);
+    }
+
+    SCovHist result;
+    result.hist = new TH1D(name.data(), "", nNew, edges.data());
+    result.nBin = nNew;
+    result.cov.assign(nNew * nNew, 0.);
+
+    // merging bins is a block sum: first sum columns
+    // within each old row, then add rows into groups
+    vector<double> partial(nOld * nNew, 0.);
+    for (size_t iOld = 0; iOld < nOld; iOld++) {
+      const double* row = &hist.cov[iOld * nOld];
+      double*       out = &partial[iOld * nNew];
+      for (size_t jOld = 0; jOld < nOld; jOld++) {
+        if (group[jOld] < 0) continue;
+        out[group[jOld]] += row[jOld];
+      }
+    }
+
+    vector<double> values(nNew, 0.);
+    for (size_t iOld = 0; iOld < nOld; iOld++) {
+      if (group[iOld] < 0) continue;
+
+      const double* row = &partial[iOld * nNew];
+      double*       out = &result.cov[group[iOld] * nNew];
+      for (size_t jNew = 0; jNew < nNew; jNew++) {
+        out[jNew] += row[jNew];
+      }
+      values[group[iOld]] += hist.hist -> GetBinContent(iOld + 1);
+    }
+
+    for (size_t iNew = 0; iNew < nNew; iNew++) {
+      result.hist -> SetBinContent(iNew + 1, values[iNew]);
+    }
+    SyncCovErrors(result);
+    return result;
+
+  }  // end 'RebinCov(SCovHist&, vector<double>&, string&)'
+
+
+
+  SCovHist SCorrelatorPlotter::DivideCov(const SCovHist& num, const SCovHist& den, const string& name) {
+
+    SCovHist result;
+    if (!num.hist || !den.hist) {
+      cerr << "WARNING: missing numerator or denominator for '" << name << "'!" << endl;
+      return result;
+    }
+    if (num.nBin != den.nBin) {
+      cerr << "WARNING: can't divide '" << num.hist -> GetName() << "' by '" << den.hist -> GetName() << "', binning differs!" << endl;
+      return result;
+    }
+
+    // treating numerator and denominator as independent:
+    //   C_r = C_n / (d d^T) + C_d (r r^T) / (d d^T)
+    const size_t   nBin = num.nBin;
+    vector<double> inv(nBin, 0.);
+    vector<double> ratio(nBin, 0.);
+    for (size_t iBin = 0; iBin < nBin; iBin++) {
+      const double denom = den.hist -> GetBinContent(iBin + 1);
+      if (denom == 0.) continue;
+      inv[iBin]   = 1. / denom;
+      ratio[iBin] = num.hist -> GetBinContent(iBin + 1) * inv[iBin];
+    }
+
+    result.hist = (TH1D*) num.hist -> Clone(name.data());
+    result.nBin = nBin;
+    result.cov.assign(nBin * nBin, 0.);
+    for (size_t iBin = 0; iBin < nBin; iBin++) {
+      const double* numRow = &num.cov[iBin * nBin];
+      const double* denRow = &den.cov[iBin * nBin];
+      double*       out    = &result.cov[iBin * nBin];
+      for (size_t jBin = 0; jBin < nBin; jBin++) {
+        const double scale = inv[iBin] * inv[jBin];
+        out[jBin] = scale * (numRow[jBin] + (denRow[jBin] * ratio[iBin] * ratio[jBin]));
+      }
+      result.hist -> SetBinContent(iBin + 1, ratio[iBin]);
+    }
+    SyncCovErrors(result);
+    return result;
+
+  }  // end 'DivideCov(SCovHist&, SCovHist&, string&)'
+
+
+
+  TH2D* SCorrelatorPlotter::MakeCovMatrixHist(const SCovHist& hist, const string& name) const {
+
+    const vector<double> edges = GetEdges(hist.hist -> GetXaxis());
+
+    TH2D* hCov = new TH2D(name.data(), "", hist.nBin, edges.data(), hist.nBin, edges.data());
+    for (size_t iBin = 0; iBin < hist.nBin; iBin++) {
+      for (size_t jBin = 0; jBin < hist.nBin; jBin++) {
+        hCov -> SetBinContent(iBin + 1, jBin + 1, hist.Cov(iBin, jBin));
+      }
+    }
+    return hCov;
+
+  }  // end 'MakeCovMatrixHist(SCovHist&, string&)'
+
+
+
+  // production comparisons ---------------------------------------------------
+
+  vector<SCompareResult> SCorrelatorPlotter::CompareFiles(const SCompareConfig& config) {
+
+    cout << "\n  Comparing '" << config.newFile << "' against '" << config.oldFile << "'..." << endl;
+
+    // file i/o isn't thread-safe, so read everything up front
+    map<string, SHistData> oldHists;
+    map<string, SHistData> newHists;
+    for (const auto& [file, hists] : {make_pair(config.oldFile, &oldHists), make_pair(config.newFile, &newHists)}) {
+      TFile* fInput = TFile::Open(file.data(), "read");
+      if (!fInput || fInput -> IsZombie()) {
+        cerr << "PANIC: couldn't open '" << file << "' for comparison!\n" << endl;
+        return vector<SCompareResult>();
+      }
+      ReadHistData(fInput, "", *hists);
+      fInput -> Close();
+    }
+    cout << "    Read " << oldHists.size() << " old and " << newHists.size() << " new histograms." << endl;
+
+    // match by name
+    vector<string> names;
+    for (const auto& entry : oldHists) names.push_back(entry.first);
+    for (const auto& entry : newHists) {
+      if (oldHists.count(entry.first) == 0) names.push_back(entry.first);
+    }
+
+    // then compare in parallel, skipping identical hashes
+    vector<SCompareResult> results(names.size());
+    ROOT::TThreadExecutor  pool(m_nThreads);
+    pool.Foreach(
+      [&](const size_t iName) {
+        const auto oldHist = oldHists.find(names[iName]);
+        const auto newHist = newHists.find(names[iName]);
+
+        SCompareResult& result = results[iName];
+        result.name = names[iName];
+        if (newHist == newHists.end()) {
+          result.isOnlyInOld   = true;
+          result.isSignificant = true;
+        } else if (oldHist == oldHists.end()) {
+          result.isOnlyInNew   = true;
+          result.isSignificant = true;
+        } else if (oldHist -> second.hash == newHist -> second.hash) {
+          result.isIdentical = true;
+        } else {
+          result = CompareHistData(oldHist -> second, newHist -> second, config);
+          result.name = names[iName];
+        }
+      },
+      ROOT::TSeq<size_t>(names.size())
+    );
+
+    // report only what changed
+    vector<SCompareResult> changed;
+    for (const SCompareResult& result : results) {
+      if (!result.isIdentical) changed.push_back(result);
+    }
+
+    ostringstream summary;
+    for (const SCompareResult& result : changed) {
+      summary << "    " << (result.isSignificant ? "[!] " : "[~] ") << result.name << ": ";
+      if (result.isOnlyInOld) {
+        summary << "only in old file";
+      } else if (result.isOnlyInNew) {
+        summary << "only in new file";
+      } else if (result.isBinDiff) {
+        summary << "binning changed";
+      } else {
+        summary << "chi2/ndf = " << result.chi2 << "/" << result.ndf
+                << ", KS prob. = " << result.ksProb
+                << ", max pull = " << result.maxPull;
+      }
+      summary << "\n";
+    }
+    cout << summary.str();
+
+    if (!config.report.empty()) {
+      ofstream report(config.report);
+      if (!report.is_open()) {
+        cerr << "WARNING: couldn't open comparison report '" << config.report << "'!" << endl;
+      }
+      report << summary.str();
+    }
+    cout << "  Finished comparison: " << changed.size() << " of " << names.size() << " histograms changed.\n" << endl;
+    return changed;
+
+  }  // end 'CompareFiles(SCompareConfig&)'
+
+
+
+  // toy mc pseudo-experiments -----------------------------------------------
+
+  vector<TGraphAsymmErrors*> SCorrelatorPlotter::MakeToyBands(const vector<TH1D*>& hists, const SToyConfig& config) {
+
+    cout << "\n  Beginning " << config.nToys << " toy experiments on " << hists.size() << " histograms..." << endl;
+
+    // all histograms go into one block, so need same binning
+    vector<TGraphAsymmErrors*> bands;
+    if (hists.empty()) {
+      cerr << "WARNING: no histograms to throw toys from!" << endl;
+      return bands;
+    }
+    if (config.ratioTo.has_value() && (config.ratioTo.value() >= hists.size())) {
+      cerr << "WARNING: reference histogram " << config.ratioTo.value() << " for toy ratios is out of range!" << endl;
+      return bands;
+    }
+
+    SVariationBlock nominal;
+    nominal.nVar = hists.size();
+    for (size_t iHist = 0; iHist < hists.size(); iHist++) {
+      if (!hists[iHist]) {
+        cerr << "WARNING: histogram " << iHist << " is null, can't throw toys!" << endl;
+        return bands;
+      }
+      if (!AppendToBlock(nominal, hists[iHist], iHist)) {
+        cerr << "WARNING: '" << hists[iHist] -> GetName() << "' has different binning, can't throw toys!" << endl;
+        return bands;
+      }
+    }
+
+    // derived observables of every toy, laid out per toy
+    // exactly like the block: [iToy][(iBin * nHist) + iHist]
+    const size_t         nCell    = nominal.values.size();
+    const uint32_t       nStream  = max(config.nPerStream, 1u);
+    const size_t         nStreams = (config.nToys + nStream - 1) / nStream;
+    const vector<double> scales(nominal.nVar, 1.);
+    vector<double>       toys(size_t(config.nToys) * nCell, 0.);
+
+    ROOT::TThreadExecutor pool(m_nThreads);
+    pool.Foreach(
+      [&](const size_t iStream) {
+
+        // reproducible stream for this chunk of toys
+        seed_seq seeds {config.seed, uint32_t(iStream)};
+        uint32_t streamSeed = 0;
+        seeds.generate(&streamSeed, &streamSeed + 1);
+        TRandom3 rng(max(streamSeed, 1u));
+
+        SVariationBlock toy = nominal;
+        const size_t    iFirst = iStream * nStream;
+        const size_t    iLast  = min(iFirst + nStream, size_t(config.nToys));
+        for (size_t iToy = iFirst; iToy < iLast; iToy++) {
+
+          // throw pseudo-data
+          for (size_t iCell = 0; iCell < nCell; iCell++) {
+            const double value = nominal.values[iCell];
+            const double error = nominal.errors[iCell];
+            if ((config.mode == Toy::Gaussian) || (value <= 0.) || (error <= 0.)) {
+              toy.values[iCell] = rng.Gaus(value, error);
+              toy.errors[iCell] = error;
+            } else {
+              const double weight = (error * error) / value;
+              const double count  = rng.PoissonD(value / weight);
+              toy.values[iCell] = count * weight;
+              toy.errors[iCell] = sqrt(count) * weight;
+            }
+          }
+
+          // and compute derived observables
+          ProcessBlock(toy, scales, config.doNorm, config.normRange, config.ratioTo);
+          copy(toy.values.begin(), toy.values.end(), &toys[iToy * nCell]);
+        }
+      },
+      ROOT::TSeq<size_t>(nStreams)
+    );
+    cout << "    Threw toys." << endl;
+
+    // observables of nominal, to center the bands
+    ProcessBlock(nominal, scales, config.doNorm, config.normRange, config.ratioTo);
+
+    // quantile bands around each bin
+    const double   qLow  = 0.5 * (1. - config.coverage);
+    const double   qHigh = 1. - qLow;
+    vector<double> values(config.nToys);
+    auto quantile = [&values](const double prob) {
+      const size_t iRank = min(size_t(prob * values.size()), values.size() - 1);
+      nth_element(values.begin(), values.begin() + iRank, values.end());
+      return values[iRank];
+    };
+
+    for (size_t iHist = 0; iHist < hists.size(); iHist++) {
+
+      TGraphAsymmErrors* band = new TGraphAsymmErrors(nominal.nBin);
+      band -> SetName( (string(hists[iHist] -> GetName()) + "_toyBand").data() );
+      band -> SetFillColor( hists[iHist] -> GetLineColor() );
+      band -> SetFillStyle(3001);
+      band -> SetLineColor( hists[iHist] -> GetLineColor() );
+
+      for (size_t iBin = 0; iBin < nominal.nBin; iBin++) {
+        if (config.nToys == 0) break;
+        for (size_t iToy = 0; iToy < config.nToys; iToy++) {
+          values[iToy] = toys[(iToy * nCell) + nominal.Index(iBin, iHist)];
+        }
+        const double low    = quantile(qLow);
+        const double high   = quantile(qHigh);
+        const double center = 0.5 * (nominal.edges[iBin] + nominal.edges[iBin + 1]);
+        const double width  = 0.5 * (nominal.edges[iBin + 1] - nominal.edges[iBin]);
+        const double value  = nominal.Value(iBin, iHist);
+        band -> SetPoint(iBin, center, value);
+        band -> SetPointError(iBin, width, width, max(value - low, 0.), max(high - value, 0.));
+      }
+      bands.push_back(band);
+    }
+    cout << "  Finished toy experiments!\n" << endl;
+    return bands;
+
+  }  // end 'MakeToyBands(vector<TH1D*>&, SToyConfig&)'
+
+
+
+  // parallel fitting ---------------------------------------------------------
+
+  vector<SFitResult> SCorrelatorPlotter::DoFits(const vector<SFitJob>& jobs) {
+
+    // fits are independent, so run them concurrently; old
+    // TMinuit keeps global state, so make sure Minuit2 is used
+    ROOT::EnableThreadSafety();
+    ROOT::Math::MinimizerOptions::SetDefaultMinimizer("Minuit2");
+
+    vector<SFitResult>    results(jobs.size());
+    ROOT::TThreadExecutor pool(m_nThreads);
+    pool.Foreach(
+      [&](const size_t iJob) {
+
+        const SFitJob& job    = jobs[iJob];
+        SFitResult&    result = results[iJob];
+        result.key = job.Key();
+        if (!job.hist) return;
+
+        // keep function out of the global list so threads don't collide
+        const string name = "fFit_" + to_string(iJob);
+        TF1 fit(name.data(), job.func.data(), job.range.first, job.range.second, TF1::EAddToList::kNo);
+
+        // warm start from cached parameters if they still match the function
+        const size_t nPar   = fit.GetNpar();
+        auto         cached = m_fitCache.find(result.key);
+        result.warm = ((cached != m_fitCache.end()) && (cached -> second.size() == nPar));
+
+        const vector<double>& seeds = result.warm ? cached -> second : job.seeds;
+        for (size_t iPar = 0; iPar < min(nPar, seeds.size()); iPar++) {
+          fit.SetParameter(iPar, seeds[iPar]);
+        }
+
+        // several jobs can share a histogram, so never attach
+        // the function to it (i.e. always fit with option "N")
+        string option = job.option;
+        if (option.find('N') == string::npos) option += "N";
+
+        result.status = job.hist -> Fit(&fit, option.data());
+        result.chi2   = fit.GetChisquare();
+        result.ndf    = fit.GetNDF();
+        for (size_t iPar = 0; iPar < nPar; iPar++) {
+          result.pars.push_back( fit.GetParameter(iPar) );
+          result.errs.push_back( fit.GetParError(iPar) );
+        }
+      },
+      ROOT::TSeq<size_t>(jobs.size())
+    );
+
+    // store converged parameters for the next round
+    for (const SFitResult& result : results) {
+      if (result.IsGood()) {
+        m_fitCache[result.key] = result.pars;
+      }
+    }
+    return results;
+
+  }  // end 'DoFits(vector<SFitJob>&)'
+
+
+
+  void SCorrelatorPlotter::SmoothHist(const SFitJob& job, const SFitResult& result) {
+
+    if (!job.hist || result.pars.empty()) {
+      cerr << "WARNING: nothing to smooth for '" << result.key << "'!" << endl;
+      return;
+    }
+
+    // rebuild function from fitted parameters
+    TF1 smoother("fSmooth", job.func.data(), job.range.first, job.range.second, TF1::EAddToList::kNo);
+    for (size_t iPar = 0; iPar < result.pars.size(); iPar++) {
+      smoother.SetParameter(iPar, result.pars[iPar]);
+    }
+
+    // replace bins inside the fit range with the function
+    for (int32_t iBin = 1; iBin <= job.hist -> GetNbinsX(); iBin++) {
+      const double center    = job.hist -> GetBinCenter(iBin);
+      const bool   isInRange = ((center > job.range.first) && (center < job.range.second));
+      if (!isInRange) continue;
+
+      job.hist -> SetBinContent(iBin, smoother.Eval(center));
+    }
+    return;
+
+  }  // end 'SmoothHist(SFitJob&, SFitResult&)'
+
+
+
+  bool SCorrelatorPlotter::LoadFitCache(const string& file) {
+
+    // cache is a text file with one fit per line:
+    //   <key>\t<nPar> <par0> <par1> ...
+    ifstream input(file);
+    if (!input.is_open()) {
+      cerr << "WARNING: couldn't open fit cache '" << file << "', fits will start cold." << endl;
+      return false;
+    }
+
+    string line;
+    while (getline(input, line)) {
+      istringstream entry(line);
+      string        key;
+      size_t        nPar = 0;
+      if (!getline(entry, key, '\t') || !(entry >> nPar)) continue;
+
+      vector<double> pars(nPar, 0.);
+      for (double& par : pars) {
+        entry >> par;
+      }
+      if (entry.fail()) continue;
+      m_fitCache[key] = pars;
+    }
+    return true;
+
+  }  // end 'LoadFitCache(string&)'
+
+
+
+  bool SCorrelatorPlotter::SaveFitCache(const string& file) const {
+
+    ofstream output(file);
+    if (!output.is_open()) {
+      cerr << "WARNING: couldn't open fit cache '" << file << "' for writing!" << endl;
+      return false;
+    }
+
+    output.precision(17);
+    for (const auto& [key, pars] : m_fitCache) {
+      output << key << "\t" << pars.size();
+      for (const double par : pars) {
+        output << " " << par;
+      }
+      output << "\n";
+    }
+    return true;
+
+  }  // end 'SaveFitCache(string&)'
+
+
+
+  // multi-slice projections --------------------------------------------------
+
+  vector<TH1*> SCorrelatorPlotter::ProjectSlices(THnBase* hist, const vector<SSliceConfig>& slices) {
+
+    vector<TH1*> projections;
+    if (!hist) {
+      cerr << "WARNING: no histogram to project!" << endl;
+      return projections;
+    }
+
+    // check slices make sense for this histogram
+    const int32_t nDim = hist -> GetNdimensions();
+    for (const SSliceConfig& slice : slices) {
+      const bool badX = ((slice.xAxis < 0) || (slice.xAxis >= nDim));
+      const bool badY = (slice.yAxis >= nDim) || (slice.yAxis == slice.xAxis);
+      if (badX || badY) {
+        cerr << "WARNING: slice '" << slice.name << "' uses axes not in '" << hist -> GetName() << "'!" << endl;
+        return projections;
+      }
+    }
+
+    // for each slice, the bins (incl. under/overflow) to
+    // keep along each axis, and the size of its buffer
+    const size_t            nSlice = slices.size();
+    vector<vector<int32_t>> binLo(nSlice, vector<int32_t>(nDim, 0));
+    vector<vector<int32_t>> binHi(nSlice, vector<int32_t>(nDim, 0));
+    vector<size_t>          nCellX(nSlice, 1);
+    vector<size_t>          nCell(nSlice, 1);
+    for (size_t iSlice = 0; iSlice < nSlice; iSlice++) {
+      const SSliceConfig& slice = slices[iSlice];
+      for (int32_t iDim = 0; iDim < nDim; iDim++) {
+        binHi[iSlice][iDim] = hist -> GetAxis(iDim) -> GetNbins() + 1;
+      }
+      for (const SAxisCut& cut : slice.cuts) {
+        if ((cut.axis < 0) || (cut.axis >= nDim)) continue;
+
+        // as in TAxis::SetRangeUser, an upper limit sitting on
+        // a bin edge doesn't pull in the bin above it
+        const TAxis* axis = hist -> GetAxis(cut.axis);
+        binLo[iSlice][cut.axis] = axis -> FindFixBin(cut.lo);
+        binHi[iSlice][cut.axis] = axis -> FindFixBin(cut.hi);
+        if ((binHi[iSlice][cut.axis] > binLo[iSlice][cut.axis]) && (axis -> GetBinLowEdge(binHi[iSlice][cut.axis]) >= cut.hi)) {
+          --binHi[iSlice][cut.axis];
+        }
+      }
+      nCellX[iSlice] = hist -> GetAxis(slice.xAxis) -> GetNbins() + 2;
+      nCell[iSlice]  = nCellX[iSlice];
+      if (slice.Is2D()) {
+        nCell[iSlice] *= hist -> GetAxis(slice.yAxis) -> GetNbins() + 2;
+      }
+    }
+
+    // thread-local sums and sums of squared errors
+    const size_t                   nThread = max(m_nThreads, 1u);
+    vector<vector<vector<double>>> sums(nThread, vector<vector<double>>(nSlice));
+    vector<vector<vector<double>>> errs(nThread, vector<vector<double>>(nSlice));
+    for (size_t iThread = 0; iThread < nThread; iThread++) {
+      for (size_t iSlice = 0; iSlice < nSlice; iSlice++) {
+        sums[iThread][iSlice].assign(nCell[iSlice], 0.);
+        errs[iThread][iSlice].assign(nCell[iSlice], 0.);
+      }
+    }
+
+    // walk the histogram once, block by block: reading bins
+    // (esp. of a THnSparse) isn't thread-safe, so each block
+    // is decoded serially and then distributed to the threads
+    const Long64_t  nBins  = hist -> GetNbins();
+    const size_t    nBlock = max(m_nScanBlock, size_t(1));
+    vector<int32_t> coords(nBlock * nDim);
+    vector<double>  contents(nBlock);
+    vector<double>  errors2(nBlock);
+
+    ROOT::TThreadExecutor pool(nThread);
+    for (Long64_t iStart = 0; iStart < nBins; iStart += nBlock) {
+
+      // decode block, dropping empty bins
+      size_t nRead = 0;
+      for (Long64_t iBin = iStart; iBin < min(iStart + Long64_t(nBlock), nBins); iBin++) {
+        const double content = hist -> GetBinContent(iBin, &coords[nRead * nDim]);
+        const double error2  = hist -> GetBinError2(iBin);
+        if ((content == 0.) && (error2 == 0.)) continue;
+
+        contents[nRead] = content;
+        errors2[nRead]  = error2;
+        ++nRead;
+      }
+
+      // and fill every slice from it
+      const size_t nPerThread = (nRead + nThread - 1) / nThread;
+      pool.Foreach(
+        [&](const size_t iThread) {
+          const size_t iFirst = iThread * nPerThread;
+          const size_t iLast  = min(iFirst + nPerThread, nRead);
+          for (size_t iRead = iFirst; iRead < iLast; iRead++) {
+
+            const int32_t* coord = &coords[iRead * nDim];
+            for (size_t iSlice = 0; iSlice < nSlice; iSlice++) {
+
+              bool isInSlice = true;
+              for (int32_t iDim = 0; iDim < nDim; iDim++) {
+                if ((coord[iDim] < binLo[iSlice][iDim]) || (coord[iDim] > binHi[iSlice][iDim])) {
+                  isInSlice = false;
+                  break;
+                }
+              }
+              if (!isInSlice) continue;
+
+              // global bin follows TH1/TH2 numbering
+              size_t iCell = coord[slices[iSlice].xAxis];
+              if (slices[iSlice].Is2D()) {
+                iCell += nCellX[iSlice] * coord[slices[iSlice].yAxis];
+              }
+              sums[iThread][iSlice][iCell] += contents[iRead];
+              errs[iThread][iSlice][iCell] += errors2[iRead];
+            }
+          }
+        },
+        ROOT::TSeq<size_t>(nThread)
+      );
+    }
+
+    // reduce thread-local buffers into output histograms
+    for (size_t iSlice = 0; iSlice < nSlice; iSlice++) {
+      for (size_t iThread = 1; iThread < nThread; iThread++) {
+        for (size_t iCell = 0; iCell < nCell[iSlice]; iCell++) {
+          sums[0][iSlice][iCell] += sums[iThread][iSlice][iCell];
+          errs[0][iSlice][iCell] += errs[iThread][iSlice][iCell];
+        }
+      }
+
+      TH1* projection = MakeSliceHist(hist, slices[iSlice]);
+      for (size_t iCell = 0; iCell < nCell[iSlice]; iCell++) {
+        projection -> SetBinContent(iCell, sums[0][iSlice][iCell]);
+        projection -> SetBinError(iCell, sqrt(errs[0][iSlice][iCell]));
+      }
+      projection -> SetEntries(projection -> GetEffectiveEntries());
+      projections.push_back(projection);
+    }
+    return projections;
+
+  }  // end 'ProjectSlices(THnBase*, vector<SSliceConfig>&)'
+
+
+
+  // batch mode and sharding -------------------------------------------------
+
+  bool SCorrelatorPlotter::RunBatch(const vector<SPlotJob>& jobs, const string& outFile, const SShard& shard) {
+
+    // pick out jobs for this shard
+    const vector<SPlotJob> toRun  = SelectShardJobs(jobs, shard);
+    const string           output = GetShardFile(outFile, shard);
+    cout << "\n  Beginning batch: shard " << shard.index << "/" << shard.count
+         << " running " << toRun.size() << " of " << jobs.size() << " jobs..."
+         << endl;
+
+    TFile* fOutput = new TFile(output.data(), "recreate");
+    if (!fOutput || fOutput -> IsZombie()) {
+      cerr << "PANIC: couldn't open shard output '" << output << "'!\n" << endl;
+      return false;
+    }
+
+    // run each job, keeping track of failures
+    bool isGood = true;
+    for (const SPlotJob& job : toRun) {
+      fOutput -> cd();
+      if (!job.plot || !job.plot(fOutput)) {
+        cerr << "WARNING: plot job '" << job.name << "' failed!" << endl;
+        isGood = false;
+        continue;
+      }
+      cout << "    Finished job '" << job.name << "'." << endl;
+    }
+
+    fOutput -> cd();
+    fOutput -> Close();
+    cout << "  Finished batch! Output in '" << output << "'.\n" << endl;
+    return isGood;
+
+  }  // end 'RunBatch(vector<SPlotJob>&, string&, SShard&)'
+
+
+
+  bool SCorrelatorPlotter::MergeShards(const string& outFile, const uint32_t nShard) {
+
+    // unsharded output is already final
+    if (nShard <= 1) return true;
+
+    TFileMerger merger(false);
+    if (!merger.OutputFile(outFile.data(), "RECREATE")) {
+      cerr << "PANIC: couldn't open merged output '" << outFile << "'!\n" << endl;
+      return false;
+    }
+
+    // every shard must be present, else the merge is incomplete
+    for (uint32_t iShard = 0; iShard < nShard; iShard++) {
+      const string input = GetShardFile(outFile, {iShard, nShard});
+      if (!merger.AddFile(input.data(), false)) {
+        cerr << "PANIC: couldn't add shard '" << input << "' to merge!\n" << endl;
+        return false;
+      }
+    }
+
+    const bool isMerged = merger.Merge();
+    if (!isMerged) {
+      cerr << "PANIC: merging shards into '" << outFile << "' failed!\n" << endl;
+    }
+    return isMerged;
+
+  }  // end 'MergeShards(string&, uint32_t)'
+
+
+
+  bool SCorrelatorPlotter::ParseShard(const string& arg, SShard& shard) const {
+
+    // accepts '--shard i/N', '--shard=i/N' or 'i/N', with i in [0, N)
+    string spec = arg;
+    for (const string prefix : {"--shard=", "--shard "}) {
+      if (spec.compare(0, prefix.size(), prefix) == 0) {
+        spec = spec.substr(prefix.size());
+        break;
+      }
+    }
+
+    uint32_t index = 0;
+    uint32_t count = 0;
+    char     slash = '\0';
+    istringstream parser(spec);
+    if (!(parser >> index >> slash >> count) || (slash != '/') || (count == 0) || (index >= count)) {
+      cerr << "WARNING: couldn't parse shard '" << arg << "', expected 'i/N' with 0 <= i < N!" << endl;
+      return false;
+    }
+
+    shard.index = index;
+    shard.count = count;
+    return true;
+
+  }  // end 'ParseShard(string&, SShard&)'
+
+
+
+  string SCorrelatorPlotter::GetShardFile(const string& outFile, const SShard& shard) const {
+
+    // no suffix needed if not sharding
+    if (shard.count <= 1) return outFile;
+
+    // e.g. 'plots.root' --> 'plots.shard0of4.root'
+    const string suffix = ".shard" + to_string(shard.index) + "of" + to_string(shard.count);
+    const size_t iExt   = outFile.rfind(".root");
+    if (iExt == string::npos) {
+      return outFile + suffix;
+    }
+    return outFile.substr(0, iExt) + suffix + outFile.substr(iExt);
+
+  }  // end 'GetShardFile(string&, SShard&)'
+
+
+
+  vector<SPlotJob> SCorrelatorPlotter::SelectShardJobs(const vector<SPlotJob>& jobs, const SShard& shard) const {
+
+    // order jobs by decreasing weight, breaking ties by
+    // name, so every shard computes the same assignment
+    // regardless of the order jobs were provided in
+    vector<pair<double, size_t>> order;
+    for (size_t iJob = 0; iJob < jobs.size(); iJob++) {
+      order.push_back( {EstimateJobWeight(jobs[iJob]), iJob} );
+    }
+    sort(order.begin(), order.end(),
+      [&jobs](const pair<double, size_t>& lhs, const pair<double, size_t>& rhs) {
+        if (lhs.first != rhs.first) return (lhs.first > rhs.first);
+        return (jobs[lhs.second].name < jobs[rhs.second].name);
+      }
+    );
+
+    // then greedily hand each job to the least loaded shard
+    const uint32_t   nShard = max(shard.count, 1u);
+    vector<double>   loads(nShard, 0.);
+    vector<SPlotJob> selected;
+    for (const auto& [weight, iJob] : order) {
+      const size_t iShard = min_element(loads.begin(), loads.end()) - loads.begin();
+      loads[iShard] += weight;
+      if (iShard == shard.index) {
+        selected.push_back( jobs[iJob] );
+      }
+    }
+    return selected;
+
+  }  // end 'SelectShardJobs(vector<SPlotJob>&, SShard&)'
+
+
+
+  // helper methods -----------------------------------------------------------
+
+  void SCorrelatorPlotter::ProcessBlock(
+    SVariationBlock& block,
+    const vector<double>& scales,
+    const bool doNorm,
+    const pair<double, double>& normRange,
+    const optional<size_t> ratioTo
+  ) const {
+
+    const size_t nBin = block.nBin;
+    const size_t nVar = block.nVar;
+
+    // scaling contents by 1/s and errors by 1/sqrt(s)
+    // can be folded into the per-variation normalization
+    // factors, so everything happens in one pass below
+    vector<double> valFactors(nVar, 1.);
+    vector<double> errFactors(nVar, 1.);
+    for (size_t iVar = 0; iVar < nVar; iVar++) {
+      valFactors[iVar] = 1. / scales[iVar];
+      errFactors[iVar] = 1. / sqrt(scales[iVar]);
+    }
+
+    // integrate every variation over the normalization range
+    if (doNorm) {
+      vector<double> integrals(nVar, 0.);
+      const size_t   iStart = FindBlockBin(block.edges, normRange.first);
+      const size_t   iStop  = FindBlockBin(block.edges, normRange.second);
+      for (size_t iBin = iStart; iBin <= iStop; iBin++) {
+        const double* row = &block.values[iBin * nVar];
+        for (size_t iVar = 0; iVar < nVar; iVar++) {
+          integrals[iVar] += row[iVar] * valFactors[iVar];
+        }
+      }
+      for (size_t iVar = 0; iVar < nVar; iVar++) {
+        const double norm = (integrals[iVar] > 0.) ? (1. / integrals[iVar]) : 1.;
+        valFactors[iVar] *= norm;
+        errFactors[iVar] *= norm;
+      }
+    }
+
+    // now apply scale, normalization and ratio bin by bin
+    for (size_t iBin = 0; iBin < nBin; iBin++) {
+
+      double* vals = &block.values[iBin * nVar];
+      double* errs = &block.errors[iBin * nVar];
+      for (size_t iVar = 0; iVar < nVar; iVar++) {
+        vals[iVar] *= valFactors[iVar];
+        errs[iVar] *= errFactors[iVar];
+      }
+      if (!ratioTo.has_value()) continue;
+
+      // divide by reference, propagating errors as in TH1::Divide
+      const double den    = vals[ratioTo.value()];
+      const double denErr = errs[ratioTo.value()];
+      const double den2   = den * den;
+      for (size_t iVar = 0; iVar < nVar; iVar++) {
+        if (den == 0.) {
+          vals[iVar] = 0.;
+          errs[iVar] = 0.;
+          continue;
+        }
+        const double num = vals[iVar];
+        const double err = errs[iVar];
+        vals[iVar] = num / den;
+        errs[iVar] = sqrt(((err * err * den2) + (denErr * denErr * num * num)) / (den2 * den2));
+      }
+    }
+    return;
+
+  }  // end 'ProcessBlock(SVariationBlock&, vector<double>&, bool, pair<double, double>&, optional<size_t>)'
+
+
+
+
+  size_t SCorrelatorPlotter::FindBlockBin(const vector<double>& edges, const double x) const {
+
+    // mirrors TH1::FindBin, but clamped to the visible bins
+    const size_t nBin = edges.size() - 1;
+    const size_t iBin = upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+    if (iBin == 0)   return 0;
+    if (iBin > nBin) return nBin - 1;
+    return iBin - 1;
+
+  }  // end 'FindBlockBin(vector<double>&, double)'
+
+
+
+  vector<double> SCorrelatorPlotter::GetEdges(const TAxis* axis) const {
+
+    // copy (possibly variable) binning of an axis
+    vector<double> edges;
+    for (int32_t iBin = 1; iBin <= axis -> GetNbins() + 1; iBin++) {
+      edges.push_back( axis -> GetBinLowEdge(iBin) );
+    }
+    return edges;
+
+  }  // end 'GetEdges(TAxis*)'
+
+
+
+  bool SCorrelatorPlotter::AppendToBlock(SVariationBlock& block, const TH1* hist, const size_t iVar, const double weight) const {
+
+    // first histogram in the block sets the binning, and
+    // every later one has to match it edge for edge
+    const size_t         nBin  = hist -> GetNbinsX();
+    const vector<double> edges = GetEdges(hist -> GetXaxis());
+    if (block.edges.empty()) {
+      block.nBin  = nBin;
+      block.edges = edges;
+      block.values.assign(nBin * block.nVar, 0.);
+      block.errors.assign(nBin * block.nVar, 0.);
+    } else if (edges != block.edges) {
+      return false;
+    }
+
+    // contents add up and errors add in quadrature, so
+    // several histograms can be summed into one variation
+    for (size_t iBin = 0; iBin < nBin; iBin++) {
+      block.Value(iBin, iVar) += weight * hist -> GetBinContent(iBin + 1);
+      block.Error(iBin, iVar)  = hypot(block.Error(iBin, iVar), weight * hist -> GetBinError(iBin + 1));
+    }
+    return true;
+
+  }  // end 'AppendToBlock(SVariationBlock&, TH1*, size_t, double)'
+
+
+
+  TH1* SCorrelatorPlotter::MakeSliceHist(THnBase* hist, const SSliceConfig& slice) const {
+
+    const TAxis*         xAxis  = hist -> GetAxis(slice.xAxis);
+    const vector<double> xEdges = GetEdges(xAxis);
+
+    TH1* projection = nullptr;
+    if (slice.Is2D()) {
+      const TAxis*         yAxis  = hist -> GetAxis(slice.yAxis);
+      const vector<double> yEdges = GetEdges(yAxis);
+      projection = new TH2D(slice.name.data(), "", xAxis -> GetNbins(), xEdges.data(), yAxis -> GetNbins(), yEdges.data());
+      projection -> GetYaxis() -> SetTitle( yAxis -> GetTitle() );
+    } else {
+      projection = new TH1D(slice.name.data(), "", xAxis -> GetNbins(), xEdges.data());
+    }
+    projection -> GetXaxis() -> SetTitle( xAxis -> GetTitle() );
+    projection -> Sumw2();
+    return projection;
+
+  }  // end 'MakeSliceHist(THnBase*, SSliceConfig&)'
+
+
+
+  double SCorrelatorPlotter::EstimateJobWeight(const SPlotJob& job) const {
+
+    if (job.weight > 0.) return job.weight;
+
+    // otherwise use total size of inputs (in bytes)
+    double weight = 0.;
+    for (const string& file : job.inFiles) {
+      FileStat_t info;
+      if (gSystem -> GetPathInfo(file.data(), info) == 0) {
+        weight += info.fSize;
+      }
+    }
+
+    // every job costs something, even without inputs
+    return max(weight, 1.);
+
+  }  // end 'EstimateJobWeight(SPlotJob&)'
+
+
+
+  const SResponseCache& SCorrelatorPlotter::GetResponse(const SUnfoldConfig& config, map<pair<const TH2*, const TH1*>, SResponseCache>& cache) const {
+
+    // reuse normalization if this response was seen before;
+    // keyed on the objects themselves since names needn't
+    // be unique across files
+    const pair<const TH2*, const TH1*> key    = {config.response, config.truth};
+    auto                               cached = cache.find(key);
+    if (cached != cache.end()) {
+      return cached -> second;
+    }
+
+    const TH2*     hResp = config.response;
+    SResponseCache response;
+    response.nDet  = hResp -> GetNbinsX();
+    response.nTrue = hResp -> GetNbinsY();
+    response.trueEdges = GetEdges(hResp -> GetYaxis());
+
+    // no. of truth entries per truth bin: from the truth
+    // histogram if given (so misses lower the efficiency)
+    // or else from the response itself
+    vector<double>  nMatch(response.nTrue, 0.);
+    vector<double>& nTruth = response.nTruth;
+    nTruth.assign(response.nTrue, 0.);
+    for (size_t iTrue = 0; iTrue < response.nTrue; iTrue++) {
+      for (size_t iDet = 0; iDet < response.nDet; iDet++) {
+        nMatch[iTrue] += hResp -> GetBinContent(iDet + 1, iTrue + 1);
+      }
+      nTruth[iTrue] = config.truth ? config.truth -> GetBinContent(iTrue + 1) : nMatch[iTrue];
+    }
+
+    // P(det | truth) and efficiency
+    response.resp.assign(response.nDet * response.nTrue, 0.);
+    response.respT.assign(response.nDet * response.nTrue, 0.);
+    response.effs.assign(response.nTrue, 0.);
+    for (size_t iTrue = 0; iTrue < response.nTrue; iTrue++) {
+      if (nTruth[iTrue] <= 0.) continue;
+      for (size_t iDet = 0; iDet < response.nDet; iDet++) {
+        const double prob = hResp -> GetBinContent(iDet + 1, iTrue + 1) / nTruth[iTrue];
+        response.resp[(iDet * response.nTrue) + iTrue] = prob;
+        response.respT[(iTrue * response.nDet) + iDet] = prob;
+      }
+      response.effs[iTrue] = nMatch[iTrue] / nTruth[iTrue];
+    }
+
+    return cache.emplace(key, response).first -> second;
+
+  }  // end 'GetResponse(SUnfoldConfig&, map<pair<TH2*, TH1*>, SResponseCache>&)'
+
+
+
+  void SCorrelatorPlotter::SyncCovErrors(SCovHist& hist) const {
+
+    for (size_t iBin = 0; iBin < hist.nBin; iBin++) {
+      hist.hist -> SetBinError(iBin + 1, sqrt(max(hist.Cov(iBin, iBin), 0.)));
+    }
+    return;
+
+  }  // end 'SyncCovErrors(SCovHist&)'
+
+
+
+  void SCorrelatorPlotter::ReadHistData(TDirectory* dir, const string& path, map<string, SHistData>& hists) const {
+
+    // keys are ordered by decreasing cycle, so keep the first of each name
+    set<string> seen;
+    for (TObject* object : *(dir -> GetListOfKeys())) {
+
+      TKey*        key  = (TKey*) object;
+      const string name = path + key -> GetName();
+      if (!seen.insert(name).second) continue;
+
+      // recurse into subdirectories
+      TClass* type = TClass::GetClass(key -> GetClassName());
+      if (!type) continue;
+      if (type -> InheritsFrom("TDirectory")) {
+        ReadHistData((TDirectory*) key -> ReadObj(), name + "/", hists);
+        continue;
+      }
+      if (!type -> InheritsFrom("TH1")) continue;
+
+      TH1* hist = (TH1*) key -> ReadObj();
+      SHistData data;
+      data.dim    = hist -> GetDimension();
+      data.nBinsX = hist -> GetNbinsX();
+      data.edges.push_back( GetEdges(hist -> GetXaxis()) );
+      if (data.dim > 1) data.edges.push_back( GetEdges(hist -> GetYaxis()) );
+      if (data.dim > 2) data.edges.push_back( GetEdges(hist -> GetZaxis()) );
+      for (int32_t iCell = 0; iCell < hist -> GetNcells(); iCell++) {
+        data.contents.push_back( hist -> GetBinContent(iCell) );
+        data.errors.push_back( hist -> GetBinError(iCell) );
+      }
+      data.hash   = HashHistData(data);
+      hists[name] = move(data);
+      delete hist;
+    }
+    return;
+
+  }  // end 'ReadHistData(TDirectory*, string&, map<string, SHistData>&)'
+
+
+
+  uint64_t SCorrelatorPlotter::HashHistData(const SHistData& data) const {
+
+    // 64-bit FNV-1a over binning, contents and errors
+    uint64_t hash   = 14695981039346656037ULL;
+    auto     hashIn = [&hash](const vector<double>& values) {
+      for (const double value : values) {
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        for (size_t iByte = 0; iByte < sizeof(bits); iByte++) {
+          hash ^= (bits >> (8 * iByte)) & 0xff;
+          hash *= 1099511628211ULL;
+        }
+      }
+    };
+    hashIn({double(data.dim), double(data.contents.size())});
+    for (const vector<double>& edges : data.edges) {
+      hashIn({double(edges.size())});
+      hashIn(edges);
+    }
+    hashIn(data.contents);
+    hashIn(data.errors);
+    return hash;
+
+  }  // end 'HashHistData(SHistData&)'
+
+
+
+  SCompareResult SCorrelatorPlotter::CompareHistData(const SHistData& oldData, const SHistData& newData, const SCompareConfig& config) const {
+
+    // binning must match along every axis, not just x
+    SCompareResult result;
+    if ((oldData.dim != newData.dim) || (oldData.edges != newData.edges) || (oldData.contents.size() != newData.contents.size())) {
+      result.isBinDiff     = true;
+      result.isSignificant = true;
+      return result;
+    }
+
+    // chi2 and pulls over every cell except under/overflow
+    // along x (other axes' flow cells are kept for simplicity)
+    const size_t nCell = oldData.contents.size();
+    const size_t nRowX = oldData.nBinsX + 2;
+    for (size_t iCell = 0; iCell < nCell; iCell++) {
+      const size_t iBinX = iCell % nRowX;
+      if ((iBinX == 0) || (iBinX == nRowX - 1)) continue;
+
+      const double diff = newData.contents[iCell] - oldData.contents[iCell];
+      const double var  = (oldData.errors[iCell] * oldData.errors[iCell]) + (newData.errors[iCell] * newData.errors[iCell]);
+      if (var <= 0.) {
+        if (diff != 0.) result.maxPull = numeric_limits<double>::infinity();
+        continue;
+      }
+      result.chi2   += (diff * diff) / var;
+      result.maxPull = max(result.maxPull, abs(diff) / sqrt(var));
+      ++result.ndf;
+    }
+
+    // KS test on visible bins of 1D histograms
+    if (oldData.dim == 1) {
+      double oldSum  = 0.;
+      double newSum  = 0.;
+      double oldSum2 = 0.;
+      double newSum2 = 0.;
+      for (int32_t iBin = 1; iBin <= oldData.nBinsX; iBin++) {
+        oldSum  += oldData.contents[iBin];
+        newSum  += newData.contents[iBin];
+        oldSum2 += oldData.errors[iBin] * oldData.errors[iBin];
+        newSum2 += newData.errors[iBin] * newData.errors[iBin];
+      }
+
+      if ((oldSum > 0.) && (newSum > 0.) && (oldSum2 > 0.) && (newSum2 > 0.)) {
+        double oldCum  = 0.;
+        double newCum  = 0.;
+        double maxDist = 0.;
+        for (int32_t iBin = 1; iBin <= oldData.nBinsX; iBin++) {
+          oldCum += oldData.contents[iBin] / oldSum;
+          newCum += newData.contents[iBin] / newSum;
+          maxDist = max(maxDist, abs(newCum - oldCum));
+        }
+
+        // effective no. of entries, as in TH1::KolmogorovTest
+        const double oldEff = (oldSum * oldSum) / oldSum2;
+        const double newEff = (newSum * newSum) / newSum2;
+        result.ksProb = TMath::KolmogorovProb(maxDist * sqrt((oldEff * newEff) / (oldEff + newEff)));
+      }
+    }
+
+    const bool isBadPull = (result.maxPull > config.maxPull);
+    const bool isBadKS   = (result.ksProb >= 0.) && (result.ksProb < config.minKSProb);
+    result.isSignificant = (isBadPull || isBadKS);
+    return result;
+
+  }  // end 'CompareHistData(SHistData&, SHistData&, SCompareConfig&)'
+
+
+
+  void SCorrelatorPlotter::SandwichCov(
+    const vector<double>& jacobian,
+    const size_t nOut,
+    const size_t nIn,
+    const vector<double>& cov,
+    vector<double>& result
+  ) const {
+
+    // result = J C J^T, done in two blocked passes:
+    //   (1) T = J C, streaming rows of C into rows of T
+    //   (2) R = T J^T, as dot products of rows of T and J
+    // output row blocks are independent, so they're
+    // spread across the thread pool
+    const size_t   nBlock    = max(m_nCovBlock, size_t(1));
+    const size_t   nRowBlock = (nOut + nBlock - 1) / nBlock;
+    vector<double> temp(nOut * nIn, 0.);
+    result.assign(nOut * nOut, 0.);
+
+    ROOT::TThreadExecutor pool(m_nThreads);
+    pool.Foreach(
+      [&](const size_t iRowBlock) {
+        const size_t iFirst = iRowBlock * nBlock;
+        const size_t iLast  = min(iFirst + nBlock, nOut);
+        for (size_t mFirst = 0; mFirst < nIn; mFirst += nBlock) {
+          const size_t mLast = min(mFirst + nBlock, nIn);
+          for (size_t iOut = iFirst; iOut < iLast; iOut++) {
+            double*       tRow = &temp[iOut * nIn];
+            const double* jRow = &jacobian[iOut * nIn];
+            for (size_t mIn = mFirst; mIn < mLast; mIn++) {
+              const double  jac  = jRow[mIn];
+              const double* cRow = &cov[mIn * nIn];
+              if (jac == 0.) continue;
+              for (size_t kIn = 0; kIn < nIn; kIn++) {
+                tRow[kIn] += jac * cRow[kIn];
+              }
+            }
+          }
+        }
+      },
+      ROOT::TSeq<size_t>(nRowBlock)
+    );
+
+    pool.Foreach(
+      [&](const size_t iRowBlock) {
+        const size_t iFirst = iRowBlock * nBlock;
+        const size_t iLast  = min(iFirst + nBlock, nOut);
+        for (size_t jFirst = 0; jFirst < nOut; jFirst += nBlock) {
+          const size_t jLast = min(jFirst + nBlock, nOut);
+          for (size_t iOut = iFirst; iOut < iLast; iOut++) {
+            const double* tRow = &temp[iOut * nIn];
+            for (size_t jOut = jFirst; jOut < jLast; jOut++) {
+              const double* jRow = &jacobian[jOut * nIn];
+              double        sum  = 0.;
+              for (size_t kIn = 0; kIn < nIn; kIn++) {
+                sum += tRow[kIn] * jRow[kIn];
+              }
+              result[(iOut * nOut) + jOut] = sum;
+            }
+          }
+        }
+      },
+      ROOT::TSeq<size_t>(nRowBlock)
+    );
+    return;
+
+  }  // end 'SandwichCov(vector<double>&, size_t, size_t, vector<double>&, vector<double>&)'
+
+
+
+  void SCorrelatorPlotter::RunUnfolding(
+    const SResponseCache& response,
+    const vector<double>& start,
+    const vector<double>& meas,
+    const vector<double>& measErr,
+    const uint32_t nIter,
+    vector<double>& unfold,
+    vector<double>& unfoldErr
+  ) const {
+
+    const size_t nDet  = response.nDet;
+    const size_t nTrue = response.nTrue;
+
+    vector<double> prior  = start;
+    vector<double> folded(nDet, 0.);
+    vector<double> weight(nDet, 0.);
+    unfold.assign(nTrue, 0.);
+    unfoldErr.assign(nTrue, 0.);
+
+    // d'agostini iterations:
+    //   f_i = sum_j R_ij p_j
+    //   u_j = (p_j / eff_j) sum_i R_ij (m_i / f_i)
+    for (uint32_t iIter = 0; iIter < max(nIter, 1u); iIter++) {
+
+      // fold prior to detector level
+      for (size_t iDet = 0; iDet < nDet; iDet++) {
+        const double* row = &response.resp[iDet * nTrue];
+        double        sum = 0.;
+        for (size_t iTrue = 0; iTrue < nTrue; iTrue++) {
+          sum += row[iTrue] * prior[iTrue];
+        }
+        folded[iDet] = sum;
+        weight[iDet] = (sum > 0.) ? (meas[iDet] / sum) : 0.;
+      }
+
+      // then back to truth level
+      double total = 0.;
+      for (size_t iTrue = 0; iTrue < nTrue; iTrue++) {
+        const double* row = &response.respT[iTrue * nDet];
+        double        sum = 0.;
+        for (size_t iDet = 0; iDet < nDet; iDet++) {
+          sum += row[iDet] * weight[iDet];
+        }
+        const double eff = response.effs[iTrue];
+        unfold[iTrue] = (eff > 0.) ? (prior[iTrue] * sum / eff) : 0.;
+        total        += unfold[iTrue];
+      }
+
+      // on the last iteration, propagate statistical errors
+      // of the measurement through the unfolding matrix,
+      // neglecting the dependence of the prior on the data
+      const bool isLast = ((iIter + 1) >= max(nIter, 1u));
+      if (isLast) {
+        for (size_t iDet = 0; iDet < nDet; iDet++) {
+          weight[iDet] = (folded[iDet] > 0.) ? (measErr[iDet] / folded[iDet]) : 0.;
+          weight[iDet] *= weight[iDet];
+        }
+        for (size_t iTrue = 0; iTrue < nTrue; iTrue++) {
+          const double* row = &response.respT[iTrue * nDet];
+          double        sum = 0.;
+          for (size_t iDet = 0; iDet < nDet; iDet++) {
+            sum += row[iDet] * row[iDet] * weight[iDet];
+          }
+          const double eff = response.effs[iTrue];
+          unfoldErr[iTrue] = (eff > 0.) ? (prior[iTrue] * sqrt(sum) / eff) : 0.;
+        }
+        break;
+      }
+
+      // otherwise unfolded result is the next prior
+      for (size_t iTrue = 0; iTrue < nTrue; iTrue++) {
+        prior[iTrue] = (total > 0.) ? (unfold[iTrue] / total) : 0.;
+      }
+    }
+    return;
+
+  }  // end 'RunUnfolding(SResponseCache&, vector<double>&, vector<double>&, vector<double>&, uint32_t, vector<double>&, vector<double>&)'
+
+
+
+  TCanvas* SCorrelatorPlotter::MakeScanCanvas(const vector<TH1D*>& hists, const SScanConfig& config, const SLumiScenario& scenario) const {
+
+    // legend: scenario header + one entry per histogram
+    const float height = 0.05 * (hists.size() + 1);
+    TLegend*    legend = new TLegend(0.3, 0.1, 0.5, 0.1 + height, scenario.label.data());
+    legend -> SetFillColor(0);
+    legend -> SetFillStyle(0);
+    legend -> SetLineColor(0);
+    legend -> SetLineStyle(0);
+    legend -> SetTextFont(42);
+    legend -> SetTextAlign(12);
+    for (size_t iHist = 0; iHist < hists.size(); iHist++) {
+      if (!hists[iHist]) continue;
+      const string label = (iHist < config.labels.size()) ? config.labels[iHist] : hists[iHist] -> GetName();
+      legend -> AddEntry(hists[iHist], label.data(), "pf");
+    }
+
+    // same canvas as the BUP plots
+    const string name = "cProjection_" + scenario.label;
+    TCanvas*     plot = new TCanvas(name.data(), "", 950, 950);
+    plot -> SetGrid(0, 0);
+    plot -> SetTicks(1, 1);
+    plot -> SetLogx(1);
+    plot -> SetLogy(1);
+    plot -> SetBorderMode(0);
+    plot -> SetBorderSize(2);
+    plot -> SetTopMargin(0.02);
+    plot -> SetRightMargin(0.02);
+    plot -> SetBottomMargin(0.15);
+    plot -> SetLeftMargin(0.15);
+    plot -> cd();
+    bool isFirst = true;
+    for (TH1D* hist : hists) {
+      if (!hist) continue;
+      hist -> GetXaxis() -> SetRangeUser(config.plotRange.first, config.plotRange.second);
+      hist -> Draw(isFirst ? "" : "same");
+      isFirst = false;
+    }
+    legend -> Draw();
+    return plot;
+
+  }  // end 'MakeScanCanvas(vector<TH1D*>&, SScanConfig&, SLumiScenario&)'
+
+
+
+  TCanvas* SCorrelatorPlotter::MakeRatioPanel(TH1D* hDen, const vector<TH1D*>& hNums, const vector<TH1D*>& hRatios, const SRatioConfig& config) const {
+
+    // legends for spectra and ratios
+    TLegend* legSpectra = new TLegend(0.1, 0.1, 0.3, 0.15 + (0.05 * (hNums.size() + 1)));
+    TLegend* legRatios  = new TLegend(0.1, 0.1, 0.3, 0.1 + (0.05 * hRatios.size()));
+    for (TLegend* legend : {legSpectra, legRatios}) {
+      legend -> SetFillColor(0);
+      legend -> SetFillStyle(0);
+      legend -> SetLineColor(0);
+      legend -> SetLineStyle(0);
+      legend -> SetTextFont(42);
+      legend -> SetTextAlign(12);
+    }
+    legSpectra -> AddEntry(hDen, hDen -> GetName(), "pf");
+    for (size_t iNum = 0; iNum < hNums.size(); iNum++) {
+      legSpectra -> AddEntry(hNums[iNum], hNums[iNum] -> GetName(), "pf");
+      legRatios  -> AddEntry(hRatios[iNum], hRatios[iNum] -> GetName(), "pf");
+    }
+
+    // line at unity
+    TLine* line = new TLine(config.plotRange.first, 1., config.plotRange.second, 1.);
+    line -> SetLineColor(1);
+    line -> SetLineStyle(9);
+    line -> SetLineWidth(1);
+
+    // same layout as the subevent ratio checks
+    const string name  = string("cRatios_") + hDen -> GetName();
+    TCanvas*     panel = new TCanvas(name.data(), "", 750, 950);
+    TPad*        pPadB = new TPad("pPadRatios",  "", 0., 0.,   1., 0.35);
+    TPad*        pPadT = new TPad("pPadSpectra", "", 0., 0.35, 1., 1.);
+    panel -> SetGrid(0, 0);
+    panel -> SetTicks(1, 1);
+    panel -> SetBorderMode(0);
+    panel -> SetBorderSize(2);
+    for (TPad* pad : {pPadB, pPadT}) {
+      pad -> SetGrid(0, 0);
+      pad -> SetTicks(1, 1);
+      pad -> SetLogx(1);
+      pad -> SetLogy(1);
+      pad -> SetBorderMode(0);
+      pad -> SetBorderSize(2);
+      pad -> SetFrameBorderMode(0);
+      pad -> SetRightMargin(0.02);
+      pad -> SetLeftMargin(0.15);
+    }
+    pPadB -> SetTopMargin(0.005);
+    pPadB -> SetBottomMargin(0.15);
+    pPadT -> SetTopMargin(0.02);
+    pPadT -> SetBottomMargin(0.005);
+    panel -> cd();
+    pPadB -> Draw();
+    pPadT -> Draw();
+
+    pPadB -> cd();
+    for (size_t iRatio = 0; iRatio < hRatios.size(); iRatio++) {
+      hRatios[iRatio] -> GetXaxis() -> SetRangeUser(config.plotRange.first, config.plotRange.second);
+      hRatios[iRatio] -> Draw((iRatio == 0) ? "" : "same");
+    }
+    line      -> Draw();
+    legRatios -> Draw();
+
+    pPadT -> cd();
+    hDen -> GetXaxis() -> SetRangeUser(config.plotRange.first, config.plotRange.second);
+    hDen -> Draw();
+    for (TH1D* hNum : hNums) {
+      hNum -> Draw("same");
+    }
+    legSpectra -> Draw();
+    return panel;
+
+  }  // end 'MakeRatioPanel(TH1D*, vector<TH1D*>&, vector<TH1D*>&, SRatioConfig&)'
+
 }  // end SColdQcdCorrelatorAnalysis namespace
 
 // end ------------------------------------------------------------------------
@@ -11,14 +11,27 @@
 #define SCORRELATORPLOTTER_H
 
 // standard c includes
+#include <map>
+#include <string>
 #include <vector>
 #include <cassert>
+#include <optional>
 #include <iostream>
 // class declarations
+#include <TF1.h>
 #include <TH1.h>
+#include <TH2.h>
 #include <TFile.h>
 #include <TTree.h>
 #include <TString.h>
+#include <THnBase.h>
+#include <TPad.h>
+#include <TLine.h>
+#include <TCanvas.h>
+#include <TLegend.h>
+#include <TGraphAsymmErrors.h>
+// plotter types
+#include "SCorrelatorPlotterTypes.h"
 
 using namespace std;
 
@@ -37,13 +50,94 @@ namespace SColdQcdCorrelatorAnalysis {
       SCorrelatorPlotter();
       ~SCorrelatorPlotter();
 
+      // setters
+      void SetNumThreads(const uint32_t nThreads) {m_nThreads   = nThreads;}
+      void SetScanBlock(const size_t nBlock)      {m_nScanBlock = nBlock;}
+      void SetCovBlock(const size_t nBlock)       {m_nCovBlock  = nBlock;}
+
       /* TODO plotting methods go here */
 
-    private:
+      // systematic variation sweeps
+      bool               DoVariationSweep(const SSweepConfig& config);
+      SVariationBlock    LoadVariations(const SSweepConfig& config);
+      void               ProcessVariations(SVariationBlock& block, const SSweepConfig& config);
+      TH1D*              MakeVariationHist(const SVariationBlock& block, const size_t iVar, const string& name);
+      TGraphAsymmErrors* MakeVariationBand(const SVariationBlock& block, const size_t nominal, const Band band, const string& name);
+
+      // luminosity projection scans
+      bool                  DoProjectionScan(const vector<TH1D*>& hists, const SScanConfig& config);
+      vector<vector<TH1D*>> ScanProjections(const vector<TH1D*>& hists, const SScanConfig& config);
+
+      // histograms from correlator trees
+      vector<TH1D*> MakeHistsFromTrees(const STreeConfig& config);
+
+      // ratio matrices
+      bool                    DoRatioMatrix(const SRatioConfig& config);
+      SVariationBlock         LoadRatioInputs(const vector<SRatioInput>& inputs);
+      vector<SVariationBlock> DivideByShared(const SVariationBlock& nums, const SVariationBlock& dens, const vector<vector<size_t>>& numsPerDen);
+
+      // unfolding
+      vector<TH1D*> UnfoldHists(const vector<TH1*>& measured, const vector<SUnfoldConfig>& configs);
+      TH1D*         UnfoldHist(TH1* measured, const SUnfoldConfig& config);
+
+      // covariance propagation
+      SCovHist MakeCovHist(TH1D* hist, const TH2* cov = nullptr);
+      void     ScaleCov(SCovHist& hist, const double valScale, const double covScale);
+      void     NormalizeCov(SCovHist& hist, const pair<double, double>& range);
+      SCovHist TransformCov(const SCovHist& hist, const vector<double>& jacobian, const vector<double>& edges, const string& name);
+      SCovHist RebinCov(const SCovHist& hist, const vector<double>& edges, const string& name);
+      SCovHist DivideCov(const SCovHist& num, const SCovHist& den, const string& name);
+      TH2D*    MakeCovMatrixHist(const SCovHist& hist, const string& name) const;
+
+      // production comparisons
+      vector<SCompareResult> CompareFiles(const SCompareConfig& config);
+
+      // toy mc pseudo-experiments
+      vector<TGraphAsymmErrors*> MakeToyBands(const vector<TH1D*>& hists, const SToyConfig& config);
+
+      // parallel fitting
+      vector<SFitResult> DoFits(const vector<SFitJob>& jobs);
+      void               SmoothHist(const SFitJob& job, const SFitResult& result);
+      bool               LoadFitCache(const string& file);
+      bool               SaveFitCache(const string& file) const;
+      void               ClearFitCache() {m_fitCache.clear();}
+
+      // multi-slice projections
+      vector<TH1*> ProjectSlices(THnBase* hist, const vector<SSliceConfig>& slices);
+
+      // batch mode and sharding
+      bool             RunBatch(const vector<SPlotJob>& jobs, const string& outFile, const SShard& shard = SShard());
+      bool             MergeShards(const string& outFile, const uint32_t nShard);
+      bool             ParseShard(const string& arg, SShard& shard) const;
+      string           GetShardFile(const string& outFile, const SShard& shard) const;
+      vector<SPlotJob> SelectShardJobs(const vector<SPlotJob>& jobs, const SShard& shard) const;
 
-      /* TODO members go here */
+    private:
 
-      /* TODO helper methods go here */
+      // atomic members
+      uint32_t m_nThreads   = 1;
+      size_t   m_nScanBlock = 65536;
+      size_t   m_nCovBlock  = 64;
+
+      // converged fit parameters, keyed by histogram + function
+      map<string, vector<double>> m_fitCache;
+
+      // helper methods
+      void                  ProcessBlock(SVariationBlock& block, const vector<double>& scales, const bool doNorm, const pair<double, double>& normRange, const optional<size_t> ratioTo) const;
+      size_t                FindBlockBin(const vector<double>& edges, const double x) const;
+      vector<double>        GetEdges(const TAxis* axis) const;
+      bool                  AppendToBlock(SVariationBlock& block, const TH1* hist, const size_t iVar, const double weight = 1.) const;
+      TH1*                  MakeSliceHist(THnBase* hist, const SSliceConfig& slice) const;
+      double                EstimateJobWeight(const SPlotJob& job) const;
+      TCanvas*              MakeScanCanvas(const vector<TH1D*>& hists, const SScanConfig& config, const SLumiScenario& scenario) const;
+      void                  RunUnfolding(const SResponseCache& response, const vector<double>& start, const vector<double>& meas, const vector<double>& measErr, const uint32_t nIter, vector<double>& unfold, vector<double>& unfoldErr) const;
+      const SResponseCache& GetResponse(const SUnfoldConfig& config, map<pair<const TH2*, const TH1*>, SResponseCache>& cache) const;
+      void                  SyncCovErrors(SCovHist& hist) const;
+      void                  ReadHistData(TDirectory* dir, const string& path, map<string, SHistData>& hists) const;
+      uint64_t              HashHistData(const SHistData& data) const;
+      SCompareResult        CompareHistData(const SHistData& oldData, const SHistData& newData, const SCompareConfig& config) const;
+      void                  SandwichCov(const vector<double>& jacobian, const size_t nOut, const size_t nIn, const vector<double>& cov, vector<double>& result) const;
+      TCanvas*              MakeRatioPanel(TH1D* hDen, const vector<TH1D*>& hNums, const vector<TH1D*>& hRatios, const SRatioConfig& config) const;
 
   };
 
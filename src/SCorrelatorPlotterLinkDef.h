@@ -1,5 +1,5 @@
 // ----------------------------------------------------------------------------
-// 'SCorrelatorPlotter.cc'
+// 'SCorrelatorPlotterLinkDef.h'
 // Derek Anderson
 // 05.25.2023
 //
@@ -7,9 +7,39 @@
 // the sPHENIX p+Au n-point energy correlator analysis.
 // ----------------------------------------------------------------------------
 
-#ifdef __CINT__
+#if defined(__CINT__) || defined(__CLING__)
 
-#pragma link C++ class SCorrelatorPlotter-!;
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+
+#pragma link C++ namespace SColdQcdCorrelatorAnalysis;
+
+#pragma link C++ class SColdQcdCorrelatorAnalysis::SCorrelatorPlotter-!;
+
+#pragma link C++ enum SColdQcdCorrelatorAnalysis::Band;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SVariationBlock-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SSweepConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SLumiScenario-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SScanConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::STreeHistConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::STreeConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SRatioInput-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SRatioConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SUnfoldConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SResponseCache-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SCovHist-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SHistData-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SCompareConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SCompareResult-!;
+#pragma link C++ enum SColdQcdCorrelatorAnalysis::Toy;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SToyConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SFitJob-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SFitResult-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SAxisCut-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SSliceConfig-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SPlotJob-!;
+#pragma link C++ struct SColdQcdCorrelatorAnalysis::SShard-!;
 
 #endif
 
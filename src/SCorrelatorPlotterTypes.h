@@ -0,0 +1,399 @@
+// ----------------------------------------------------------------------------
+// 'SCorrelatorPlotterTypes.h'
+//
+// Configuration and data structures used by the
+// SCorrelatorPlotter class.
+// ----------------------------------------------------------------------------
+
+#ifndef SCORRELATORPLOTTERTYPES_H
+#define SCORRELATORPLOTTERTYPES_H
+
+// standard c includes
+#include <string>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <cstdint>
+#include <functional>
+// root includes
+#include <TH1.h>
+#include <TH2.h>
+#include <TFile.h>
+
+using namespace std;
+
+
+
+namespace SColdQcdCorrelatorAnalysis {
+
+  // variation sweep types ----------------------------------------------------
+
+  // how variations are combined into an uncertainty band
+  enum class Band {Envelope, Quadrature};
+
+
+
+  // all variations of a single histogram, stored as a
+  // structure-of-arrays so that every variation of a
+  // given bin is contiguous: index = (iBin * nVar) + iVar
+  struct SVariationBlock {
+
+    size_t         nBin = 0;
+    size_t         nVar = 0;
+    vector<double> edges;
+    vector<double> values;
+    vector<double> errors;
+    vector<string> labels;
+
+    // accessors
+    size_t  Index(const size_t iBin, const size_t iVar) const {return (iBin * nVar) + iVar;}
+    double& Value(const size_t iBin, const size_t iVar)       {return values[Index(iBin, iVar)];}
+    double& Error(const size_t iBin, const size_t iVar)       {return errors[Index(iBin, iVar)];}
+    double  Value(const size_t iBin, const size_t iVar) const {return values[Index(iBin, iVar)];}
+    double  Error(const size_t iBin, const size_t iVar) const {return errors[Index(iBin, iVar)];}
+
+  };  // end SVariationBlock
+
+
+
+  // options for a systematic-variation sweep
+  struct SSweepConfig {
+
+    // io parameters: one input file and histogram per variation
+    vector<string> inFiles;
+    vector<string> inHists;
+    vector<string> labels;
+    string         outFile;
+    string         outName;
+
+    // index of nominal variation
+    size_t nominal = 0;
+
+    // processing options: note that projScale is a BUP-style
+    // projection factor (e.g. nSimEvts / nTargetEvts), so
+    // contents are DIVIDED by it and errors by its sqrt
+    bool                 doScale   = false;
+    bool                 doNorm    = false;
+    bool                 doRatio   = false;
+    double               projScale = 1.;
+    pair<double, double> normRange = {0., 1.};
+    Band                 band      = Band::Envelope;
+
+  };  // end SSweepConfig
+
+
+
+  // luminosity projection types ---------------------------------------------
+
+  // one luminosity scenario: simulation is scaled to the
+  // expected no. of events, nColl * lumi * xsec, using
+  // scale = nSimEvts / (nColl * lumi * xsec)
+  struct SLumiScenario {
+
+    string label;
+    double lumi    = 8.0e7;   // target lumi [mb^-1]
+    double xsec    = 0.0363;  // x-section of simulated process [mb]
+    double nSimEvt = 1.4e7;   // no. of simulated events
+    double nColl   = 197.;    // e.g. 197 for p+Au, 1 for p+p
+
+    double ScaleFactor() const {return nSimEvt / (nColl * lumi * xsec);}
+
+  };  // end SLumiScenario
+
+
+
+  // options for a multi-luminosity projection scan
+  struct SScanConfig {
+
+    vector<SLumiScenario> scenarios;
+    vector<string>        labels;  // legend label per histogram
+    string                outFile;
+    bool                  doNorm    = true;
+    pair<double, double>  normRange = {0.03, 1.};
+    pair<double, double>  plotRange = {0.03, 1.};
+
+  };  // end SScanConfig
+
+
+
+  // tree histogram types ----------------------------------------------------
+
+  // a histogram to fill from the correlator trees: 'var'
+  // and 'weight' can be scalar or collection columns
+  // (e.g. one entry per pair), 'cut' is any expression
+  // RDataFrame can jit, e.g. "(ptJet >= 10) && (ptJet < 20)"
+  struct STreeHistConfig {
+
+    string         name;
+    string         var;
+    string         weight;
+    string         cut;
+    vector<double> edges;
+
+  };  // end STreeHistConfig
+
+
+
+  // trees to loop over and histograms to book on them
+  struct STreeConfig {
+
+    string                  tree;
+    vector<string>          inFiles;
+    vector<STreeHistConfig> hists;
+
+  };  // end STreeConfig
+
+
+
+  // ratio matrix types ------------------------------------------------------
+
+  // one numerator or denominator of a ratio matrix: the
+  // sum of one or more (file, histogram) parts, e.g. the
+  // signal + background subevents of a sample
+  struct SRatioInput {
+
+    string                       label;
+    vector<pair<string, string>> parts;
+    double                       weight = 1.;
+
+  };  // end SRatioInput
+
+
+
+  // options for a ratio matrix: if no (numerator,
+  // denominator) pairs are given, every numerator is
+  // divided by every denominator
+  struct SRatioConfig {
+
+    vector<SRatioInput>          numerators;
+    vector<SRatioInput>          denominators;
+    vector<pair<size_t, size_t>> pairs;
+    string                       outFile;
+    bool                         doPanels  = true;
+    pair<double, double>         plotRange = {0.0005, 1.};
+
+  };  // end SRatioConfig
+
+
+
+  // unfolding types ---------------------------------------------------------
+
+  // options for iterative bayesian unfolding: the response
+  // has detector level along x and truth level along y;
+  // if provided, truth (incl. misses) sets the efficiency
+  // and prior sets the starting point of the iterations
+  struct SUnfoldConfig {
+
+    TH2*     response = nullptr;
+    TH1*     truth    = nullptr;
+    TH1*     prior    = nullptr;
+    uint32_t nIter    = 4;
+
+  };  // end SUnfoldConfig
+
+
+
+  // response normalized to P(detector bin | truth bin),
+  // stored both row-major (det x truth) and transposed
+  // so both folding and unfolding run along contiguous rows;
+  // nTruth (truth entries per bin) is the default prior
+  struct SResponseCache {
+
+    size_t         nDet  = 0;
+    size_t         nTrue = 0;
+    vector<double> trueEdges;
+    vector<double> resp;
+    vector<double> respT;
+    vector<double> effs;
+    vector<double> nTruth;
+
+  };  // end SResponseCache
+
+
+
+  // covariance types --------------------------------------------------------
+
+  // a histogram and the covariance of its (visible) bins,
+  // stored row-major: cov[(iBin * nBin) + jBin]
+  struct SCovHist {
+
+    TH1D*          hist = nullptr;
+    size_t         nBin = 0;
+    vector<double> cov;
+
+    double& Cov(const size_t iBin, const size_t jBin)       {return cov[(iBin * nBin) + jBin];}
+    double  Cov(const size_t iBin, const size_t jBin) const {return cov[(iBin * nBin) + jBin];}
+
+  };  // end SCovHist
+
+
+
+  // comparison types --------------------------------------------------------
+
+  // plain copy of a histogram (all cells, incl. under/
+  // overflow, and the edges of each axis) so it can be
+  // compared off the main thread
+  struct SHistData {
+
+    int32_t                dim    = 1;
+    int32_t                nBinsX = 0;
+    vector<vector<double>> edges;
+    vector<double>         contents;
+    vector<double>         errors;
+    uint64_t               hash   = 0;
+
+  };  // end SHistData
+
+
+
+  // options for comparing two productions
+  struct SCompareConfig {
+
+    string oldFile;
+    string newFile;
+    string report;            // optional text report
+    double maxPull   = 3.;    // flag if any |pull| exceeds this
+    double minKSProb = 0.01;  // or if KS prob. falls below this
+
+  };  // end SCompareConfig
+
+
+
+  // outcome of comparing one histogram between productions
+  struct SCompareResult {
+
+    string  name;
+    bool    isIdentical   = false;
+    bool    isOnlyInOld   = false;
+    bool    isOnlyInNew   = false;
+    bool    isBinDiff     = false;
+    bool    isSignificant = false;
+    double  chi2          = 0.;
+    int32_t ndf           = 0;
+    double  ksProb        = -1.;
+    double  maxPull       = 0.;
+
+  };  // end SCompareResult
+
+
+
+  // toy mc types ------------------------------------------------------------
+
+  // how pseudo-data are thrown: poisson uses the effective
+  // no. of entries, (content / error)^2, of each bin so it
+  // also works for weighted or scaled histograms
+  enum class Toy {Poisson, Gaussian};
+
+
+
+  // options for toy-mc pseudo-experiments; toys are split
+  // into fixed-size streams, each with its own generator
+  // seeded from (seed, stream), so results don't depend
+  // on the no. of threads
+  struct SToyConfig {
+
+    uint32_t             nToys      = 1000;
+    uint32_t             nPerStream = 64;
+    uint32_t             seed       = 12345;
+    Toy                  mode       = Toy::Poisson;
+    bool                 doNorm     = true;
+    pair<double, double> normRange  = {0.03, 1.};
+    optional<size_t>     ratioTo    = nullopt;
+    double               coverage   = 0.68;
+
+  };  // end SToyConfig
+
+
+
+  // fitting types ------------------------------------------------------------
+
+  // a single fit of a function to a histogram; seeds
+  // are only used if no cached parameters exist
+  struct SFitJob {
+
+    TH1*                 hist = nullptr;
+    string               func;
+    vector<double>       seeds;
+    pair<double, double> range  = {0., 1.};
+    string               option = "RNQ";
+
+    // cache key: histogram name + function
+    string Key() const {return string(hist ? hist -> GetName() : "") + "::" + func;}
+
+  };  // end SFitJob
+
+
+
+  // parameters of a fit and its quality
+  struct SFitResult {
+
+    string         key;
+    vector<double> pars;
+    vector<double> errs;
+    double         chi2   = 0.;
+    int32_t        ndf    = 0;
+    int32_t        status = -1;
+    bool           warm   = false;
+
+    bool IsGood() const {return (status == 0);}
+
+  };  // end SFitResult
+
+
+
+  // projection types ---------------------------------------------------------
+
+  // a range [lo, hi] (in axis units) to keep along one axis
+  struct SAxisCut {
+
+    int32_t axis = 0;
+    double  lo   = 0.;
+    double  hi   = 0.;
+
+  };  // end SAxisCut
+
+
+
+  // a 1D or 2D slice of an N-dimensional histogram
+  struct SSliceConfig {
+
+    string           name;
+    int32_t          xAxis = 0;
+    int32_t          yAxis = -1;  // < 0 for a 1D slice
+    vector<SAxisCut> cuts;
+
+    bool Is2D() const {return (yAxis >= 0);}
+
+  };  // end SSliceConfig
+
+
+
+  // batch types --------------------------------------------------------------
+
+  // one plot job of a batch: the plotting routine writes
+  // its output into the file it's handed; if no weight
+  // is provided, the size of the inputs is used
+  struct SPlotJob {
+
+    string                 name;
+    vector<string>         inFiles;
+    double                 weight = 0.;
+    function<bool(TFile*)> plot;
+
+  };  // end SPlotJob
+
+
+
+  // which slice of a batch to run: shard 'index' of 'count'
+  struct SShard {
+
+    uint32_t index = 0;
+    uint32_t count = 1;
+
+  };  // end SShard
+
+}  // end SColdQcdCorrelatorAnalysis namespace
+
+#endif
+
+// end ------------------------------------------------------------------------